@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: MIT */
+/* Copyright (c) 2026 Wayne6530 */
+
+/*
+ * libsmoothscroll: the smooth scroll engine for use inside another process, such as a compositor that reads the
+ * mouse itself. It takes raw evdev events and returns smoothed ones; it does no I/O and never blocks.
+ *
+ * Typical use from an event loop:
+ *
+ *   smoothscroll* ss = smoothscroll_create();
+ *   smoothscroll_set_option(ss, "damping", 3.1);
+ *   ...
+ *   for (;;) {
+ *     int64_t deadline = smoothscroll_next_deadline(ss);
+ *     wait for input, or until `deadline` if it is not -1;
+ *     if input arrived:
+ *       smoothscroll_feed_mouse(ss, &ev);  (every event, including SYN_REPORT)
+ *     else:
+ *       smoothscroll_advance(ss, current time);
+ *     n = smoothscroll_pull(ss, out, capacity);
+ *     deliver out[0..n) as if they came from the mouse;
+ *   }
+ *   smoothscroll_destroy(ss);
+ *
+ * Timestamps are microseconds since the Unix epoch, the clock of evdev event timestamps (CLOCK_REALTIME).
+ * A context is not thread safe.
+ */
+
+#ifndef SMOOTHSCROLL_H
+#define SMOOTHSCROLL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <linux/input.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SMOOTHSCROLL_API_VERSION 1
+
+/* The library is built with hidden visibility; only these functions are exported. */
+#if defined(__GNUC__)
+#define SMOOTHSCROLL_EXPORT __attribute__((visibility("default")))
+#else
+#define SMOOTHSCROLL_EXPORT
+#endif
+
+typedef struct smoothscroll smoothscroll;
+
+/* Returns SMOOTHSCROLL_API_VERSION of the loaded library. */
+SMOOTHSCROLL_EXPORT int smoothscroll_api_version(void);
+
+/*
+ * Creates a context with default options. Returns NULL on allocation failure.
+ *
+ * No C++ exception ever leaves the library: functions that return int report a failure to allocate, or any other
+ * internal error, as -1.
+ */
+SMOOTHSCROLL_EXPORT smoothscroll* smoothscroll_create(void);
+
+SMOOTHSCROLL_EXPORT void smoothscroll_destroy(smoothscroll* ss);
+
+/*
+ * Sets an option by its config file name (see /etc/smooth-scroll/smooth-scroll.toml), e.g. "damping",
+ * "initial_speed", "use_reverse_scroll_braking", "free_spin_button". Boolean options take 0 or 1.
+ * Options can only be set before the first event is fed. Returns 0 on success, -1 if the name is unknown, the value
+ * is out of range (a tick interval below 1 microsecond) or the context has already started.
+ */
+SMOOTHSCROLL_EXPORT int smoothscroll_set_option(smoothscroll* ss, const char* name, double value);
+
+/* Keys that stop scrolling when pressed on a keyboard. Same rules as smoothscroll_set_option(). */
+SMOOTHSCROLL_EXPORT int smoothscroll_add_braking_key(smoothscroll* ss, unsigned int code);
+
+/* Keys that disable smoothing while held, and also brake. Same rules as smoothscroll_set_option(). */
+SMOOTHSCROLL_EXPORT int smoothscroll_add_passthrough_key(smoothscroll* ss, unsigned int code);
+
+/*
+ * Feeds one event from the mouse. Frames become available to smoothscroll_pull() at SYN_REPORT. Returns 0 on
+ * success, -1 on failure.
+ */
+SMOOTHSCROLL_EXPORT int smoothscroll_feed_mouse(smoothscroll* ss, const struct input_event* ev);
+
+/*
+ * Feeds one event from a keyboard. `keyboard` is any id the caller uses to tell keyboards apart. Returns 0 on
+ * success, -1 on failure.
+ */
+SMOOTHSCROLL_EXPORT int smoothscroll_feed_keyboard(smoothscroll* ss, int keyboard, const struct input_event* ev);
+
+/* Forgets a keyboard, releasing any passthrough keys still held on it. */
+SMOOTHSCROLL_EXPORT void smoothscroll_remove_keyboard(smoothscroll* ss, int keyboard);
+
+/* Time of the next tick, or -1 while not scrolling. */
+SMOOTHSCROLL_EXPORT int64_t smoothscroll_next_deadline(const smoothscroll* ss);
+
+/* Runs the tick due at smoothscroll_next_deadline(). Returns 1 if it produced a frame, 0 otherwise, -1 on failure. */
+SMOOTHSCROLL_EXPORT int smoothscroll_tick(smoothscroll* ss);
+
+/*
+ * Runs every tick due at `now` as a single frame carrying their summed output, so a caller that woke up late
+ * catches up with real time in one step. Does nothing if no tick is due. Returns 1 if it produced a frame, 0 if not
+ * and -1 on failure.
+ */
+SMOOTHSCROLL_EXPORT int smoothscroll_advance(smoothscroll* ss, int64_t now);
+
+/*
+ * Copies up to `capacity` pending output events into `events` and returns how many were copied. Output consists
+ * of complete frames, each ending in SYN_REPORT; call again until it returns less than `capacity`.
+ */
+SMOOTHSCROLL_EXPORT size_t smoothscroll_pull(smoothscroll* ss, struct input_event* events, size_t capacity);
+
+/* Stops the current scroll immediately. */
+SMOOTHSCROLL_EXPORT void smoothscroll_brake(smoothscroll* ss);
+
+/* While enabled, wheel events pass through unsmoothed. */
+SMOOTHSCROLL_EXPORT void smoothscroll_set_passthrough(smoothscroll* ss, int enabled);
+
+/* Current scroll speed in hi-res wheel units per second, 0 when idle. */
+SMOOTHSCROLL_EXPORT double smoothscroll_speed(const smoothscroll* ss);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMOOTHSCROLL_H */
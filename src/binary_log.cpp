@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "binary_log.h"
+
+#include <fmt/format.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+constexpr std::array<const char*, static_cast<size_t>(LogEvent::kCount)> kLogEventFormats = {
+  "reverse scroll stop",
+  "braking dejitter",
+  "initial speed {:.2f}",
+  "set speed: actual {:.2f} target {:.2f}",
+  "damping stop, total {}",
+  "tick speed {:.2f} deceleration {:.2f}",
+  "movement stop",
+};
+
+constexpr auto kFlushInterval = std::chrono::milliseconds{ 20 };
+
+}  // namespace
+
+namespace detail
+{
+
+std::atomic<BinaryLog*> active_binary_log{ nullptr };
+
+thread_local bool log_events_disabled = false;
+
+void formatLogEvent(std::chrono::system_clock::time_point time, LogEvent event, double a, double b)
+{
+  auto index = static_cast<size_t>(event);
+  spdlog::default_logger_raw()->log(time, spdlog::source_loc{}, kLogEventLevels[index],
+                                    fmt::format(fmt::runtime(kLogEventFormats[index]), a, b));
+}
+
+}  // namespace detail
+
+BinaryLog::~BinaryLog()
+{
+  stop();
+}
+
+void BinaryLog::start()
+{
+  if (running_.exchange(true))
+    return;
+
+  thread_ = std::thread(&BinaryLog::run, this);
+  detail::active_binary_log.store(this, std::memory_order_release);
+}
+
+void BinaryLog::stop()
+{
+  if (!running_.exchange(false))
+    return;
+
+  detail::active_binary_log.store(nullptr, std::memory_order_release);
+  thread_.join();
+  drain();
+}
+
+void BinaryLog::push(LogEvent event, double a, double b) noexcept
+{
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) == kCapacity)
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto& record = records_[head & (kCapacity - 1)];
+  record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+  record.event = event;
+  record.values[0] = a;
+  record.values[1] = b;
+
+  head_.store(head + 1, std::memory_order_release);
+}
+
+void BinaryLog::run()
+{
+  while (running_.load(std::memory_order_relaxed))
+  {
+    drain();
+    std::this_thread::sleep_for(kFlushInterval);
+  }
+}
+
+void BinaryLog::drain()
+{
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t head = head_.load(std::memory_order_acquire);
+
+  for (; tail != head; ++tail)
+  {
+    const auto& record = records_[tail & (kCapacity - 1)];
+    std::chrono::system_clock::time_point time{ std::chrono::duration_cast<std::chrono::system_clock::duration>(
+        std::chrono::nanoseconds{ record.time }) };
+    detail::formatLogEvent(time, record.event, record.values[0], record.values[1]);
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  if (auto dropped = dropped_.exchange(0, std::memory_order_relaxed))
+  {
+    SPDLOG_WARN("Debug log ring full, {} records dropped", dropped);
+  }
+}
+
+}  // namespace smooth_scroll
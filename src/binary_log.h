@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+// Debug messages emitted on the input path. Each one is a fixed format string with up to two numeric arguments,
+// see kLogEventFormats in binary_log.cpp.
+enum class LogEvent : uint16_t
+{
+  kReverseScrollStop,
+  kBrakingDejitter,
+  kInitialSpeed,
+  kSetSpeed,
+  kDampingStop,
+  kTickSpeed,
+  kMovementStop,
+  kCount,
+};
+
+constexpr std::array<spdlog::level::level_enum, static_cast<size_t>(LogEvent::kCount)> kLogEventLevels = {
+  spdlog::level::debug, spdlog::level::debug, spdlog::level::debug, spdlog::level::debug,
+  spdlog::level::debug, spdlog::level::trace, spdlog::level::debug,
+};
+
+// Asynchronous sink for LogEvent records. While started, logEvent() copies a 32-byte record into a single-producer
+// single-consumer ring instead of formatting, and a background thread formats the records through spdlog with
+// their original timestamps. When the ring is full records are dropped and counted rather than blocking the input
+// thread. Only one thread may call logEvent() while a log is started.
+class BinaryLog
+{
+public:
+  static constexpr size_t kCapacity = 4096;
+
+  BinaryLog() = default;
+
+  ~BinaryLog();
+
+  BinaryLog(const BinaryLog&) = delete;
+  BinaryLog& operator=(const BinaryLog&) = delete;
+
+  // Starts the formatter thread and routes logEvent() here.
+  void start();
+
+  // Routes logEvent() back to synchronous formatting, then formats whatever is left in the ring.
+  void stop();
+
+  void push(LogEvent event, double a, double b) noexcept;
+
+private:
+  struct Record
+  {
+    int64_t time;  // system_clock nanoseconds
+    LogEvent event;
+    double values[2];
+  };
+
+  static_assert(sizeof(Record) == 32);
+  static_assert((kCapacity & (kCapacity - 1)) == 0);
+
+  void run();
+
+  void drain();
+
+  std::array<Record, kCapacity> records_;
+  alignas(64) std::atomic<size_t> head_{ 0 };
+  alignas(64) std::atomic<size_t> tail_{ 0 };
+  std::atomic<uint64_t> dropped_{ 0 };
+  std::atomic_bool running_{ false };
+  std::thread thread_;
+};
+
+namespace detail
+{
+
+extern std::atomic<BinaryLog*> active_binary_log;
+
+// Set on threads whose smoothers must not log, such as the shadow smoother's: BinaryLog takes one producer only.
+extern thread_local bool log_events_disabled;
+
+void formatLogEvent(std::chrono::system_clock::time_point time, LogEvent event, double a, double b);
+
+}  // namespace detail
+
+inline void logEvent(LogEvent event, double a = 0, double b = 0) noexcept
+{
+  auto level = kLogEventLevels[static_cast<size_t>(event)];
+  if (level < SPDLOG_ACTIVE_LEVEL || !spdlog::should_log(level) || detail::log_events_disabled)
+    return;
+
+  if (auto* log = detail::active_binary_log.load(std::memory_order_acquire))
+  {
+    log->push(event, a, b);
+  }
+  else
+  {
+    detail::formatLogEvent(std::chrono::system_clock::now(), event, a, b);
+  }
+}
+
+}  // namespace smooth_scroll
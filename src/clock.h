@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include <sys/time.h>
+
+namespace smooth_scroll
+{
+
+// Where the event loop and device detection read the time and how they wait for a deadline. Times are microseconds
+// since the epoch, the base of input event timestamps. The smoother never reads a clock: it runs on event timestamps
+// and the tick times it is given.
+class Clock
+{
+public:
+  virtual ~Clock() = default;
+
+  [[nodiscard]] virtual std::chrono::microseconds now() const noexcept = 0;
+
+  // The select() timeout that wakes the caller at `deadline`, zero once it has passed, or nullopt to wait for input
+  // only.
+  [[nodiscard]] virtual std::optional<struct timeval> waitUntil(std::chrono::microseconds deadline) noexcept = 0;
+
+  // An input event stamped `time` was read.
+  virtual void onInput(std::chrono::microseconds /*time*/) noexcept
+  {
+  }
+
+  // Input stamped before this time has all been written to the sources, so the caller can order it across sources by
+  // timestamp. Input from it on is held back until the limit moves.
+  [[nodiscard]] virtual std::chrono::microseconds inputLimit() const noexcept
+  {
+    return std::chrono::microseconds::max();
+  }
+};
+
+class SystemClock final : public Clock
+{
+public:
+  [[nodiscard]] static SystemClock& instance() noexcept
+  {
+    static SystemClock clock;
+    return clock;
+  }
+
+  [[nodiscard]] std::chrono::microseconds now() const noexcept override
+  {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+  }
+
+  [[nodiscard]] std::optional<struct timeval> waitUntil(std::chrono::microseconds deadline) noexcept override
+  {
+    auto usec = std::max((deadline - now()).count(), int64_t{ 0 });
+
+    struct timeval timeout;
+    timeout.tv_sec = usec / 1'000'000;
+    timeout.tv_usec = usec % 1'000'000;
+    return timeout;
+  }
+};
+
+// A clock that moves only when told to, for tests and simulation. Waiting for a deadline jumps straight to it, so an
+// event loop on a virtual clock never sleeps and runs hours of ticks in as long as they take to compute. Reading input
+// moves the clock up to the input's timestamp. Whoever feeds the loop from another thread sets a limit: the time up
+// to which all input has been written, on every source. Deadlines from it on are not jumped to and input stamped from
+// it on is not handled yet; the loop waits for more input instead, so neither ticks nor one source run ahead of input
+// that is merely slow to arrive, and the same input always plays out the same way.
+class VirtualClock final : public Clock
+{
+public:
+  explicit VirtualClock(std::chrono::microseconds start = std::chrono::microseconds{ 0 }) noexcept
+    : now_{ start.count() }
+  {
+  }
+
+  [[nodiscard]] std::chrono::microseconds now() const noexcept override
+  {
+    return std::chrono::microseconds{ now_.load(std::memory_order_relaxed) };
+  }
+
+  [[nodiscard]] std::optional<struct timeval> waitUntil(std::chrono::microseconds deadline) noexcept override
+  {
+    if (deadline >= std::chrono::microseconds{ limit_.load(std::memory_order_acquire) })
+      return std::nullopt;
+
+    advanceTo(deadline);
+    return timeval{ 0, 0 };
+  }
+
+  void onInput(std::chrono::microseconds time) noexcept override
+  {
+    advanceTo(time);
+  }
+
+  // Never moves the clock backwards.
+  void advanceTo(std::chrono::microseconds time) noexcept
+  {
+    int64_t current = now_.load(std::memory_order_relaxed);
+    while (current < time.count() && !now_.compare_exchange_weak(current, time.count(), std::memory_order_relaxed))
+    {
+    }
+  }
+
+  void advance(std::chrono::microseconds duration) noexcept
+  {
+    now_.fetch_add(duration.count(), std::memory_order_relaxed);
+  }
+
+  // Input stamped before `time` has all been written. There is no limit until one is set.
+  void setLimit(std::chrono::microseconds time) noexcept
+  {
+    limit_.store(time.count(), std::memory_order_release);
+  }
+
+  [[nodiscard]] std::chrono::microseconds inputLimit() const noexcept override
+  {
+    return std::chrono::microseconds{ limit_.load(std::memory_order_acquire) };
+  }
+
+private:
+  std::atomic<int64_t> now_;
+  std::atomic<int64_t> limit_{ std::numeric_limits<int64_t>::max() };
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,157 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "device_calibrator.h"
+
+#include "state_dir.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+// The fast spin notch interval the default options were tuned on.
+constexpr double kReferenceNotchInterval = 10000;
+
+// Longer gaps between notches, or between pointer reports, end a spin or a motion.
+constexpr std::chrono::microseconds kMaxNotchInterval{ 200000 };
+constexpr std::chrono::microseconds kMaxReportInterval{ 50000 };
+
+constexpr uint32_t kWheelSamples = 300;
+constexpr uint32_t kReportSamples = 2000;
+
+}  // namespace
+
+void applyDeviceProfile(const DeviceProfile& profile, WheelSmoother::Options& options)
+{
+  if (profile.wheel_notch_interval.count() > 0)
+  {
+    double scale = std::clamp(profile.wheel_notch_interval.count() / kReferenceNotchInterval, 0.5, 2.0);
+    options.speed_factor *= scale;
+    options.initial_speed *= scale;
+    options.speed_smooth_window_microseconds =
+        std::max(static_cast<int>(std::lround(options.speed_smooth_window_microseconds * scale)),
+                 4 * options.tick_interval_microseconds);
+    SPDLOG_INFO("Device profile: notch interval {}us, speed and smoothing window scaled by {:.3}",
+                profile.wheel_notch_interval.count(), scale);
+  }
+
+  if (profile.report_interval.count() > 0)
+  {
+    int window = static_cast<int>(std::ceil(3 * profile.report_interval.count() / 1000.0));
+    options.mouse_movement_window_milliseconds = std::max(options.mouse_movement_window_milliseconds, window);
+    SPDLOG_INFO("Device profile: report interval {}us, mouse movement window {}ms", profile.report_interval.count(),
+                options.mouse_movement_window_milliseconds);
+  }
+}
+
+DeviceCalibrator::DeviceCalibrator(std::string profile_path, std::string identity)
+  : profile_path_{ std::move(profile_path) }, identity_{ std::move(identity) }
+{
+}
+
+bool DeviceCalibrator::onFrame(const struct input_event* events, size_t count) noexcept
+{
+  if (done_ || count == 0)
+    return done_;
+
+  std::chrono::microseconds time = std::chrono::seconds{ events[count - 1].time.tv_sec } +
+                                   std::chrono::microseconds{ events[count - 1].time.tv_usec };
+  bool motion = false;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    const auto& ev = events[i];
+    if (ev.type != EV_REL || ev.value == 0)
+      continue;
+
+    if (ev.code == REL_X || ev.code == REL_Y)
+    {
+      motion = true;
+    }
+    else if (ev.code == REL_WHEEL || ev.code == REL_HWHEEL)
+    {
+      auto interval = time - last_wheel_time_;
+      if (ev.code == last_wheel_code_ && (ev.value > 0) == (last_wheel_value_ > 0) && interval < kMaxNotchInterval)
+      {
+        // A report of several notches stands for that many evenly spaced ones.
+        wheel_intervals_.add(interval / std::abs(ev.value));
+      }
+      last_wheel_time_ = time;
+      last_wheel_value_ = ev.value;
+      last_wheel_code_ = ev.code;
+    }
+  }
+
+  if (motion)
+  {
+    if (time - last_report_time_ < kMaxReportInterval)
+    {
+      report_intervals_.add(time - last_report_time_);
+    }
+    last_report_time_ = time;
+  }
+
+  if (wheel_intervals_.count() < kWheelSamples || report_intervals_.count() < kReportSamples)
+    return false;
+
+  done_ = true;
+  profile_.wheel_notch_interval = wheel_intervals_.quantile(0.1);
+  profile_.report_interval = report_intervals_.mode();
+  return true;
+}
+
+bool DeviceCalibrator::save() const
+{
+  if (!done_)
+    return false;
+
+  SPDLOG_INFO("Calibrated {}: notch interval {}us, report interval {}us, applies from the next start", identity_,
+              profile_.wheel_notch_interval.count(), profile_.report_interval.count());
+  return writeStateFile(profile_path_, fmt::format("# Measured by smooth-scroll for {}\n"
+                                                   "wheel_notch_interval_microseconds = {}\n"
+                                                   "report_interval_microseconds = {}\n",
+                                                   identity_, profile_.wheel_notch_interval.count(),
+                                                   profile_.report_interval.count()));
+}
+
+void DeviceCalibrator::Histogram::add(std::chrono::microseconds interval) noexcept
+{
+  size_t bucket = 0;
+  if (interval.count() > 64)
+  {
+    bucket = std::min(static_cast<size_t>(4 * std::log2(interval.count() / 64.0)), kBuckets - 1);
+  }
+
+  ++counts_[bucket];
+  sums_[bucket] += interval.count();
+  ++count_;
+}
+
+std::chrono::microseconds DeviceCalibrator::Histogram::quantile(double fraction) const noexcept
+{
+  double target = fraction * count_;
+  uint32_t seen = 0;
+  for (size_t i = 0; i < kBuckets; ++i)
+  {
+    seen += counts_[i];
+    if (counts_[i] != 0 && seen >= target)
+      return std::chrono::microseconds{ sums_[i] / counts_[i] };
+  }
+  return std::chrono::microseconds{ 0 };
+}
+
+std::chrono::microseconds DeviceCalibrator::Histogram::mode() const noexcept
+{
+  size_t fullest = std::max_element(counts_.begin(), counts_.end()) - counts_.begin();
+  return std::chrono::microseconds{ counts_[fullest] ? sums_[fullest] / counts_[fullest] : 0 };
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <linux/input.h>
+
+#include "wheel_smoother.h"
+
+namespace smooth_scroll
+{
+
+// What a mouse's wheel and sensor look like in time. Measured once by DeviceCalibrator and kept per vendor and
+// product id.
+struct DeviceProfile
+{
+  // Interval between notches when the wheel is spun fast, the 10th percentile of notch intervals within a spin. This
+  // is how fast the user spins this wheel, so it follows the user's hand as much as the wheel's notches per turn,
+  // which evdev does not report.
+  std::chrono::microseconds wheel_notch_interval{ 0 };
+  // Interval between pointer reports during continuous motion, a property of the sensor.
+  std::chrono::microseconds report_interval{ 0 };
+};
+
+// Scales the speed and smoothing options from the fast spin cadence the defaults were tuned on to the one measured,
+// so a wheel whose fast spins come with twice the notches scrolls the same distance per spin, and widens the mouse
+// movement window to hold a few reports of a slow sensor. The cadence adapts the options to the user on this model
+// more than to the hardware.
+void applyDeviceProfile(const DeviceProfile& profile, WheelSmoother::Options& options);
+
+// Measures a DeviceProfile from the live mouse frames with fixed size histograms, so feeding it costs a few
+// arithmetic operations per frame and never allocates. Once enough wheel and pointer samples are in, the profile is
+// complete, and save() writes it to `profile_path` as TOML at shutdown, away from the input path.
+class DeviceCalibrator
+{
+public:
+  DeviceCalibrator(std::string profile_path, std::string identity);
+
+  DeviceCalibrator(const DeviceCalibrator&) = delete;
+  DeviceCalibrator& operator=(const DeviceCalibrator&) = delete;
+
+  // Returns true once the profile is complete; later frames are ignored.
+  bool onFrame(const struct input_event* events, size_t count) noexcept;
+
+  // Writes the profile if it is complete. Returns false if it is not or the write failed.
+  bool save() const;
+
+private:
+  // Quarter octave buckets from 64us, up to about 4s.
+  class Histogram
+  {
+  public:
+    void add(std::chrono::microseconds interval) noexcept;
+
+    [[nodiscard]] uint32_t count() const noexcept
+    {
+      return count_;
+    }
+
+    // Mean of the samples in the bucket holding the given fraction of all samples.
+    [[nodiscard]] std::chrono::microseconds quantile(double fraction) const noexcept;
+
+    // Mean of the samples in the fullest bucket.
+    [[nodiscard]] std::chrono::microseconds mode() const noexcept;
+
+  private:
+    static constexpr size_t kBuckets = 64;
+
+    std::array<uint32_t, kBuckets> counts_{};
+    std::array<int64_t, kBuckets> sums_{};
+    uint32_t count_ = 0;
+  };
+
+  std::string profile_path_;
+  std::string identity_;
+  bool done_ = false;
+  DeviceProfile profile_;
+
+  Histogram wheel_intervals_;
+  std::chrono::microseconds last_wheel_time_{ 0 };
+  int32_t last_wheel_value_ = 0;
+  uint16_t last_wheel_code_ = 0;
+
+  Histogram report_intervals_;
+  std::chrono::microseconds last_report_time_{ 0 };
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "device_scan.h"
+
+#include "evdev_backend.h"
+#include "state_dir.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string_view>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+void probe(DeviceScan::Device& device)
+{
+  device.fd = open(device.path.c_str(), O_RDONLY | O_NONBLOCK);
+  if (device.fd < 0)
+  {
+    SPDLOG_WARN("Failed to open device {}: {}", device.path, strerror(errno));
+    return;
+  }
+
+  int rc = libevdev_new_from_fd(device.fd, &device.evdev);
+  if (rc < 0)
+  {
+    SPDLOG_WARN("Failed to initialize libevdev for {}: {}", device.path, strerror(-rc));
+    close(device.fd);
+    device.fd = -1;
+    device.evdev = nullptr;
+    return;
+  }
+
+  libevdev* dev = device.evdev;
+  device.is_mouse = libevdev_has_event_type(dev, EV_REL) && libevdev_has_event_code(dev, EV_REL, REL_X) &&
+                    libevdev_has_event_code(dev, EV_REL, REL_Y) && libevdev_has_event_code(dev, EV_REL, REL_WHEEL);
+
+  const char* name = libevdev_get_name(dev);
+  const char* phys = libevdev_get_phys(dev);
+  device.identity = fmt::format("{:04x}:{:04x}:{:04x} {}", libevdev_get_id_bustype(dev),
+                                libevdev_get_id_vendor(dev), libevdev_get_id_product(dev), name ? name : "");
+  device.phys = phys ? phys : "";
+}
+
+}  // namespace
+
+DeviceScan::~DeviceScan()
+{
+  release();
+}
+
+void DeviceScan::release() noexcept
+{
+  for (auto& device : devices_)
+  {
+    if (device.evdev)
+    {
+      libevdev_free(device.evdev);
+    }
+
+    if (device.fd >= 0)
+    {
+      close(device.fd);
+    }
+  }
+  devices_.clear();
+}
+
+bool DeviceScan::run(const std::string& exclude)
+{
+  DIR* dir = opendir("/dev/input");
+  if (!dir)
+  {
+    SPDLOG_ERROR("Failed to open /dev/input directory");
+    return false;
+  }
+
+  std::vector<Device> found;
+  dirent* entry;
+  while ((entry = readdir(dir)) != nullptr)
+  {
+    std::string_view name = entry->d_name;
+    if (name.rfind("event", 0) == 0)
+    {
+      std::string path = "/dev/input/" + std::string(name);
+      if (path != exclude)
+      {
+        found.emplace_back();
+        found.back().path = std::move(path);
+      }
+    }
+  }
+  closedir(dir);
+
+  std::vector<std::thread> threads;
+  threads.reserve(found.size());
+  for (auto& device : found)
+  {
+    threads.emplace_back(probe, std::ref(device));
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for (auto& device : found)
+  {
+    if (device.fd < 0)
+      continue;
+
+    if (device.phys == kUinputPhys)
+    {
+      SPDLOG_DEBUG("Skip virtual device {}", device.path);
+      libevdev_free(device.evdev);
+      close(device.fd);
+      continue;
+    }
+
+    SPDLOG_DEBUG("Found device {}: {}{}", device.path, device.identity, device.is_mouse ? " (mouse)" : "");
+    devices_.push_back(std::move(device));
+  }
+
+  return true;
+}
+
+LastDevice loadLastDevice(const std::string& path)
+{
+  LastDevice last;
+  std::ifstream file(path);
+  std::getline(file, last.identity);
+  std::getline(file, last.phys);
+  return last;
+}
+
+bool saveLastDevice(const std::string& path, const DeviceScan::Device& device)
+{
+  return writeStateFile(path, device.identity + '\n' + device.phys + '\n');
+}
+
+}  // namespace smooth_scroll
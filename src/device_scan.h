@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <libevdev-1.0/libevdev/libevdev.h>
+
+namespace smooth_scroll
+{
+
+// Opens every /dev/input/event* device and probes it, so the mouse and the keyboards come out of one scan. Devices
+// are probed in parallel: some (Bluetooth, KVM switches) take tens of milliseconds to answer their ioctls, and a
+// serial scan waits for each in turn. Devices still held when the scan is released or destroyed are closed.
+class DeviceScan
+{
+public:
+  struct Device
+  {
+    std::string path;
+    int fd = -1;
+    libevdev* evdev = nullptr;
+    bool is_mouse = false;
+
+    // Bus, vendor, product and name. Unlike the event node, it stays the same across reboots and replugging.
+    std::string identity;
+    // Where the device is connected, to tell apart two devices of the same model.
+    std::string phys;
+  };
+
+  DeviceScan() = default;
+
+  ~DeviceScan();
+
+  DeviceScan(const DeviceScan&) = delete;
+  DeviceScan& operator=(const DeviceScan&) = delete;
+
+  // Skips `exclude`, which is already open. Returns false if /dev/input can't be read.
+  bool run(const std::string& exclude = {});
+
+  // Devices that were opened successfully. Take a device by moving out its fd and evdev.
+  [[nodiscard]] std::vector<Device>& devices() noexcept
+  {
+    return devices_;
+  }
+
+  // Closes every device that was not taken.
+  void release() noexcept;
+
+private:
+  std::vector<Device> devices_;
+};
+
+// The device picked last time, as saved by saveLastDevice(). Empty if there is none.
+struct LastDevice
+{
+  std::string identity;
+  std::string phys;
+};
+
+LastDevice loadLastDevice(const std::string& path);
+
+bool saveLastDevice(const std::string& path, const DeviceScan::Device& device);
+
+}  // namespace smooth_scroll
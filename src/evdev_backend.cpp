@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "evdev_backend.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+constexpr size_t kLongBits = sizeof(unsigned long) * CHAR_BIT;
+
+bool isWheelCode(int code) noexcept
+{
+  return code == REL_WHEEL || code == REL_HWHEEL || code == REL_WHEEL_HI_RES || code == REL_HWHEEL_HI_RES;
+}
+
+bool takesCode(UinputOutputSink::Role role, int type, int code) noexcept
+{
+  switch (role)
+  {
+    case UinputOutputSink::Role::kPointer:
+      return type != EV_REL || !isWheelCode(code);
+
+    case UinputOutputSink::Role::kWheel:
+      return (type == EV_REL && (isWheelCode(code) || code == REL_X || code == REL_Y)) ||
+             (type == EV_KEY && code == BTN_LEFT);
+
+    case UinputOutputSink::Role::kClone:
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+EvdevInputSource::EvdevInputSource(int fd, libevdev* evdev) noexcept : fd_(fd), evdev_(evdev), reader_(fd)
+{
+}
+
+EvdevInputSource::~EvdevInputSource()
+{
+  if (grabbed_)
+  {
+    libevdev_grab(evdev_, LIBEVDEV_UNGRAB);
+  }
+  libevdev_free(evdev_);
+  close(fd_);
+}
+
+ReadStatus EvdevInputSource::next(struct input_event& ev) noexcept
+{
+  while (true)
+  {
+    int result = libevdev_next_event(evdev_, read_flag_, &ev);
+
+    if (result == LIBEVDEV_READ_STATUS_SYNC)
+    {
+      if (ev.type == EV_SYN && ev.code == SYN_DROPPED)
+      {
+        read_flag_ = LIBEVDEV_READ_FLAG_SYNC;
+        ++syn_dropped_;
+        continue;
+      }
+      return ReadStatus::kSuccess;
+    }
+    else if (result == LIBEVDEV_READ_STATUS_SUCCESS)
+    {
+      return ReadStatus::kSuccess;
+    }
+
+    read_flag_ = LIBEVDEV_READ_FLAG_NORMAL;
+    return result == -ENODEV ? ReadStatus::kLost : ReadStatus::kAgain;
+  }
+}
+
+bool EvdevInputSource::grab() noexcept
+{
+  grabbed_ = libevdev_grab(evdev_, LIBEVDEV_GRAB) == 0;
+  return grabbed_;
+}
+
+UinputOutputSink::~UinputOutputSink()
+{
+  if (created_)
+  {
+    ioctl(fd_, UI_DEV_DESTROY);
+  }
+
+  if (fd_ >= 0)
+  {
+    close(fd_);
+  }
+}
+
+bool UinputOutputSink::create(libevdev* source, std::vector<int>& supported_buttons, Role role)
+{
+  fd_ = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+  if (fd_ < 0)
+  {
+    SPDLOG_ERROR("failed to open /dev/uinput");
+    return false;
+  }
+
+  SPDLOG_INFO("Input device name: \"{}\"", libevdev_get_name(source));
+  SPDLOG_INFO("Input device ID: bus {:#x} vendor {:#x} product {:#x}", libevdev_get_id_bustype(source),
+              libevdev_get_id_vendor(source), libevdev_get_id_product(source));
+
+  // One EVIOCGBIT per type fetches the whole bitmap, and only the codes that are set cost an ioctl.
+  int source_fd = libevdev_get_fd(source);
+  auto clone_bits = [&](int type, unsigned long set_bit, auto& bits) -> bool {
+    if (!libevdev_has_event_type(source, type))
+      return true;
+
+    if (ioctl(source_fd, EVIOCGBIT(type, sizeof(bits)), bits) < 0)
+    {
+      SPDLOG_ERROR("Failed to read event type {} capabilities: {}", type, strerror(errno));
+      return false;
+    }
+
+    const char* type_name = libevdev_event_type_get_name(type);
+    SPDLOG_DEBUG("  Event type {} ({}) supported", type, type_name ? type_name : "?");
+    ioctl(fd_, UI_SET_EVBIT, type);
+
+    for (size_t i = 0; i < std::size(bits); ++i)
+    {
+      for (unsigned long word = bits[i]; word != 0; word &= word - 1)
+      {
+        int code = static_cast<int>(i * kLongBits) + __builtin_ctzl(word);
+        if (!takesCode(role, type, code))
+          continue;
+
+        const char* code_name = libevdev_event_code_get_name(type, code);
+        SPDLOG_DEBUG("    Event code {} ({})", code, code_name ? code_name : "?");
+        ioctl(fd_, set_bit, code);
+        if (type == EV_KEY)
+        {
+          supported_buttons.push_back(code);
+        }
+      }
+    }
+    return true;
+  };
+
+  unsigned long key_bits[(KEY_CNT + kLongBits - 1) / kLongBits] = {};
+  unsigned long rel_bits[(REL_CNT + kLongBits - 1) / kLongBits] = {};
+  unsigned long msc_bits[(MSC_CNT + kLongBits - 1) / kLongBits] = {};
+  if (!clone_bits(EV_KEY, UI_SET_KEYBIT, key_bits) || !clone_bits(EV_REL, UI_SET_RELBIT, rel_bits) ||
+      !clone_bits(EV_MSC, UI_SET_MSCBIT, msc_bits))
+  {
+    return false;
+  }
+
+  // The clone carries the mouse's ids, so consumers apply the same per-device settings and quirks, and its name
+  // with a suffix so it can be told apart. The phys marks it as ours for device scans.
+  ioctl(fd_, UI_SET_PHYS, kUinputPhys);
+
+  struct uinput_setup setup;
+  memset(&setup, 0, sizeof(setup));
+  snprintf(setup.name, UINPUT_MAX_NAME_SIZE, role == Role::kWheel ? "%s Smooth Scroll Wheel" : "%s Smooth Scroll",
+           libevdev_get_name(source));
+  setup.id.bustype = libevdev_get_id_bustype(source);
+  setup.id.vendor = libevdev_get_id_vendor(source);
+  setup.id.product = libevdev_get_id_product(source);
+  setup.id.version = libevdev_get_id_version(source);
+
+  if (ioctl(fd_, UI_DEV_SETUP, &setup) < 0)
+  {
+    // Kernels before 4.5 only know the legacy setup structure.
+    struct uinput_user_dev uidev;
+    memset(&uidev, 0, sizeof(uidev));
+    memcpy(uidev.name, setup.name, sizeof(uidev.name));
+    uidev.id = setup.id;
+
+    if (::write(fd_, &uidev, sizeof(uidev)) < 0)
+    {
+      SPDLOG_ERROR("Write uidev failed");
+      return false;
+    }
+  }
+
+  if (ioctl(fd_, UI_DEV_CREATE) < 0)
+  {
+    SPDLOG_ERROR("Unable to create uinput device");
+    return false;
+  }
+
+  SPDLOG_INFO("Created virtual device \"{}\"", setup.name);
+  created_ = true;
+  return true;
+}
+
+WriteStatus UinputOutputSink::write(const struct input_event* events, size_t count, size_t& written) noexcept
+{
+  written = 0;
+  while (written < count)
+  {
+    ssize_t n = ::write(fd_, events + written, (count - written) * sizeof(struct input_event));
+    if (n > 0)
+    {
+      written += n / sizeof(struct input_event);
+      continue;
+    }
+
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n < 0 && errno == EAGAIN)
+      return WriteStatus::kAgain;
+
+    SPDLOG_ERROR("Write uinput failed: {}", n < 0 ? strerror(errno) : "nothing written");
+    return WriteStatus::kFailed;
+  }
+
+  return WriteStatus::kSuccess;
+}
+
+}  // namespace smooth_scroll
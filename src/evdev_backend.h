@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <vector>
+
+#include <libevdev-1.0/libevdev/libevdev.h>
+
+#include "frame_reader.h"
+#include "io_backend.h"
+
+namespace smooth_scroll
+{
+
+// Reads a /dev/input/event* device. next() goes through libevdev; nextFrame() reads the fd directly in bulk and does
+// its own SYN_DROPPED recovery. Takes ownership of the fd and the libevdev handle.
+class EvdevInputSource : public InputSource
+{
+public:
+  EvdevInputSource(int fd, libevdev* evdev) noexcept;
+
+  ~EvdevInputSource() override;
+
+  EvdevInputSource(const EvdevInputSource&) = delete;
+  EvdevInputSource& operator=(const EvdevInputSource&) = delete;
+
+  [[nodiscard]] int fd() const noexcept override
+  {
+    return fd_;
+  }
+
+  ReadStatus next(struct input_event& ev) noexcept override;
+
+  ReadStatus nextFrame(Frame& frame) noexcept override
+  {
+    return reader_.next(frame);
+  }
+
+  [[nodiscard]] uint64_t syn_dropped() const noexcept override
+  {
+    return syn_dropped_ + reader_.syn_dropped();
+  }
+
+  bool grab() noexcept;
+
+  [[nodiscard]] libevdev* evdev() const noexcept
+  {
+    return evdev_;
+  }
+
+private:
+  int fd_;
+  libevdev* evdev_;
+  int read_flag_ = LIBEVDEV_READ_FLAG_NORMAL;
+  bool grabbed_ = false;
+  uint64_t syn_dropped_ = 0;  // seen by next()
+  FrameReader reader_;
+};
+
+// The phys of the virtual devices UinputOutputSink creates.
+constexpr char kUinputPhys[] = "smooth-scroll/uinput";
+
+// Writes frames to a virtual device created through /dev/uinput.
+class UinputOutputSink : public OutputSink
+{
+public:
+  // Which of the source's capabilities the virtual device takes.
+  enum class Role
+  {
+    kClone,    // all of them
+    kPointer,  // all but the wheel
+    // The wheel, plus motion and a left button that are never sent, so that udev and libinput take it for a mouse.
+    kWheel,
+  };
+
+  UinputOutputSink() = default;
+
+  ~UinputOutputSink() override;
+
+  UinputOutputSink(const UinputOutputSink&) = delete;
+  UinputOutputSink& operator=(const UinputOutputSink&) = delete;
+
+  // Creates a clone of `source` with its ids and its key, relative and misc capabilities, or the part of them `role`
+  // picks. The key codes it supports are appended to `supported_buttons`.
+  bool create(libevdev* source, std::vector<int>& supported_buttons, Role role = Role::kClone);
+
+  [[nodiscard]] int fd() const noexcept override
+  {
+    return fd_;
+  }
+
+  WriteStatus write(const struct input_event* events, size_t count, size_t& written) noexcept override;
+
+private:
+  int fd_ = -1;
+  bool created_ = false;
+};
+
+}  // namespace smooth_scroll
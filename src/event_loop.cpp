@@ -0,0 +1,552 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "event_loop.h"
+
+#include "probes.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+std::chrono::microseconds eventTime(const struct input_event& ev)
+{
+  return std::chrono::seconds{ ev.time.tv_sec } + std::chrono::microseconds{ ev.time.tv_usec };
+}
+
+}  // namespace
+
+EventLoop::EventLoop(const Options& options, const WheelSmoother::Options& smoother_options, IpcServer& ipc,
+                     InputSource& mouse, std::vector<std::unique_ptr<InputSource>> keyboards, OutputSink& output,
+                     OutputSink* wheel_output, Clock& clock)
+  : clock_{ clock }
+  , ipc_{ ipc }
+  , mouse_{ mouse }
+  , output_{ output }
+  , router_{ options, smoother_options }
+  , tick_tracer_{ clock }
+  , timer_slack_{ options.scroll_timer_slack_ns }
+{
+  if (wheel_output)
+  {
+    wheel_output_.emplace(*wheel_output);
+  }
+
+  keyboards_.reserve(keyboards.size());
+  for (auto& keyboard : keyboards)
+  {
+    keyboards_.push_back(Keyboard{ std::move(keyboard), 0, 0, false, false, std::nullopt });
+  }
+
+  setFds();
+}
+
+void EventLoop::setFds() noexcept
+{
+  max_fd_ = mouse_.fd();
+  FD_ZERO(&fds_);
+  FD_SET(mouse_.fd(), &fds_);
+  for (const auto& keyboard : keyboards_)
+  {
+    FD_SET(keyboard.source->fd(), &fds_);
+    if (keyboard.source->fd() > max_fd_)
+    {
+      max_fd_ = keyboard.source->fd();
+    }
+  }
+}
+
+bool EventLoop::writeFrames(OutputQueue& queue, const std::vector<struct input_event>& events) noexcept
+{
+  // One write per frame, so that the queue merges or drops each frame on its own and every one fits a queue slot.
+  // The router ends every frame it outputs with SYN_REPORT.
+  size_t begin = 0;
+  for (size_t i = 0; i < events.size(); ++i)
+  {
+    const auto& ev = events[i];
+    if (ev.type != EV_SYN || ev.code != SYN_REPORT)
+      continue;
+
+    size_t count = i + 1 - begin;
+    bool ok = queue.write(events.data() + begin, count);
+    SMOOTH_SCROLL_PROBE3(write_events, ev.time.tv_sec * 1'000'000 + ev.time.tv_usec, count, ok);
+    if (!ok)
+      return false;
+
+    if (metrics_)
+    {
+      metrics_->output_frames.add();
+    }
+    begin = i + 1;
+  }
+  return true;
+}
+
+bool EventLoop::writeOutput() noexcept
+{
+  const auto& events = router_.output();
+  const auto& wheel_events = router_.wheel_output();
+  if (metrics_)
+  {
+    metrics_->output_events.add(events.size() + wheel_events.size());
+  }
+
+  bool ok = writeFrames(output_, events) && writeFrames(wheelQueue(), wheel_events);
+  router_.clearOutput();
+  return ok;
+}
+
+void EventLoop::recordSession() noexcept
+{
+  if (!journal_ && !metrics_)
+    return;
+
+  if (auto session = router_.takeEndedSession())
+  {
+    if (metrics_)
+    {
+      metrics_->stops[static_cast<int>(session->stop_reason)].add();
+    }
+
+    if (journal_)
+    {
+      journal_->append(*session, session_latency_);
+    }
+    session_latency_ = std::chrono::microseconds{ 0 };
+  }
+}
+
+void EventLoop::updateMetrics() noexcept
+{
+  if (!metrics_)
+    return;
+
+  metrics_->scrolling.store(router_.next_tick_time().has_value(), std::memory_order_relaxed);
+
+  bool passthrough = router_.state().passthrough > 0 || ipc_.isForcePassthroughEnabled();
+  if (passthrough != passthrough_start_.has_value())
+  {
+    if (passthrough)
+    {
+      passthrough_start_ = clock_.now();
+      metrics_->passthrough_start_us.store(passthrough_start_->count(), std::memory_order_relaxed);
+    }
+    else
+    {
+      metrics_->passthrough_start_us.store(0, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      metrics_->passthrough_us.add((clock_.now() - *passthrough_start_).count());
+      passthrough_start_.reset();
+    }
+    metrics_->passthrough.store(passthrough, std::memory_order_relaxed);
+  }
+
+  if (auto syn_dropped = mouse_.syn_dropped(); syn_dropped != mouse_syn_dropped_)
+  {
+    metrics_->syn_dropped.add(syn_dropped - mouse_syn_dropped_);
+    mouse_syn_dropped_ = syn_dropped;
+  }
+
+  uint64_t stalls = output_.stalls();
+  uint64_t merged_frames = output_.merged_frames();
+  uint64_t dropped_frames = output_.dropped_frames();
+  if (wheel_output_)
+  {
+    stalls += wheel_output_->stalls();
+    merged_frames += wheel_output_->merged_frames();
+    dropped_frames += wheel_output_->dropped_frames();
+  }
+  metrics_->output_stalls.set(stalls);
+  metrics_->output_merged_frames.set(merged_frames);
+  metrics_->output_dropped_frames.set(dropped_frames);
+}
+
+void EventLoop::publishState() noexcept
+{
+  recordSession();
+  updateMetrics();
+
+  auto state = router_.state();
+  if (state == published_state_)
+    return;
+
+  if (state.passthrough != published_state_.passthrough)
+  {
+    ipc_.setPassthrough(state.passthrough);
+  }
+
+  if (state.free_spin != published_state_.free_spin)
+  {
+    ipc_.setFreeSpin(state.free_spin);
+  }
+
+  // Entering drag view clears the speed bits, so the speed is always written after it.
+  if (state.drag_view != published_state_.drag_view)
+  {
+    ipc_.setDragView(state.drag_view);
+  }
+
+  ipc_.setSpeed(state.speed, state.positive, state.horizontal);
+
+  published_state_ = state;
+}
+
+bool EventLoop::tick(std::chrono::microseconds now)
+{
+  auto scheduled = router_.next_tick_time();
+  bool output = router_.tick(now);
+  if (scheduled)
+  {
+    tick_tracer_.onTick(*scheduled, output);
+
+    if (metrics_)
+    {
+      metrics_->ticks.add();
+      if (!output)
+      {
+        metrics_->empty_ticks.add();
+      }
+    }
+  }
+
+  return writeOutput();
+}
+
+bool EventLoop::run(const std::atomic_bool& shutdown)
+{
+  while (!shutdown.load(std::memory_order_relaxed))
+  {
+    fd_set read_fds = fds_;
+    fd_set write_fds;
+    FD_ZERO(&write_fds);
+    int max_fd = max_fd_;
+    for (OutputQueue* queue : { &output_, &wheelQueue() })
+    {
+      if (!queue->empty() && queue->fd() >= 0)
+      {
+        FD_SET(queue->fd(), &write_fds);
+        max_fd = std::max(max_fd, queue->fd());
+      }
+    }
+
+    bool scrolling = router_.next_tick_time().has_value();
+    timer_slack_.setScrolling(scrolling);
+    tick_tracer_.setEnabled(ipc_.isTickTraceEnabled());
+    tick_tracer_.onState(scrolling);
+
+    // Read before waiting, so that whatever was written before it is already readable when select() returns.
+    auto input_limit = clock_.inputLimit();
+
+    std::optional<struct timeval> timeout;
+    if (auto next_tick_time = router_.next_tick_time())
+    {
+      timeout = clock_.waitUntil(*next_tick_time);
+    }
+
+    int select_ret = select(max_fd + 1, &read_fds, &write_fds, NULL, timeout.has_value() ? &timeout.value() : NULL);
+    if (select_ret < 0)
+    {
+      if (errno == EINTR)
+      {
+        SPDLOG_TRACE("select errno EINTR");
+        tick_tracer_.onWakeup(TickTracer::Wakeup::kInterrupted);
+        continue;
+      }
+
+      SPDLOG_ERROR("select error: {}", select_ret);
+      return false;
+    }
+
+    if (ipc_.checkBrakeSignal())
+    {
+      SMOOTH_SCROLL_PROBE(brake_signal);
+      if (metrics_)
+      {
+        metrics_->brake_signals.add();
+      }
+      router_.brake();
+    }
+    router_.setForcePassthrough(ipc_.isForcePassthroughEnabled());
+
+    if (select_ret == 0)
+    {
+      tick_tracer_.onWakeup(TickTracer::Wakeup::kTimeout);
+
+      // Input read ahead and held back by the limit comes before the ticks it precedes.
+      bool ok = handleInput(read_fds, input_limit) && tick(clock_.now());
+      publishState();
+      if (!ok)
+      {
+        return false;
+      }
+      continue;
+    }
+
+    if (output_.fd() >= 0 && FD_ISSET(output_.fd(), &write_fds))
+    {
+      if (!output_.flush())
+      {
+        return false;
+      }
+    }
+
+    if (wheel_output_ && wheel_output_->fd() >= 0 && FD_ISSET(wheel_output_->fd(), &write_fds))
+    {
+      if (!wheel_output_->flush())
+      {
+        return false;
+      }
+    }
+
+    if (FD_ISSET(mouse_.fd(), &read_fds))
+    {
+      tick_tracer_.onWakeup(TickTracer::Wakeup::kMouse);
+    }
+
+    if (std::any_of(keyboards_.begin(), keyboards_.end(),
+                    [&](const Keyboard& keyboard) { return FD_ISSET(keyboard.source->fd(), &read_fds); }))
+    {
+      tick_tracer_.onWakeup(TickTracer::Wakeup::kKeyboard);
+    }
+
+    if (!handleInput(read_fds, input_limit))
+    {
+      return false;
+    }
+
+    if (auto next_tick_time = router_.next_tick_time())
+    {
+      if (eventTime(ev_) > *next_tick_time)
+      {
+        if (!tick(clock_.now()))
+        {
+          return false;
+        }
+      }
+    }
+
+    publishState();
+  }
+
+  return true;
+}
+
+bool EventLoop::handleInput(const fd_set& read_fds, std::chrono::microseconds limit)
+{
+  mouse_readable_ |= FD_ISSET(mouse_.fd(), &read_fds);
+  for (auto& keyboard : keyboards_)
+  {
+    keyboard.readable |= FD_ISSET(keyboard.source->fd(), &read_fds);
+  }
+
+  // Every source that may have more gets its next frame or event read ahead, and the earliest of them is handled,
+  // the mouse first on a tie, until nothing before the limit is left.
+  bool mouse_lost = false;
+  bool keyboard_lost = false;
+  while (true)
+  {
+    if (mouse_frame_.count == 0 && mouse_readable_)
+    {
+      ReadStatus result = mouse_.nextFrame(mouse_frame_);
+      if (result != ReadStatus::kSuccess)
+      {
+        mouse_frame_ = Frame{};
+        mouse_readable_ = false;
+        mouse_lost = result == ReadStatus::kLost;
+      }
+    }
+
+    std::optional<std::chrono::microseconds> first_time;
+    if (mouse_frame_.count != 0)
+    {
+      first_time = eventTime(mouse_frame_.events[mouse_frame_.count - 1]);
+    }
+
+    Keyboard* first_keyboard = nullptr;
+    for (auto& keyboard : keyboards_)
+    {
+      if (!keyboard.pending && keyboard.readable)
+      {
+        struct input_event ev;
+        ReadStatus result = keyboard.source->next(ev);
+        if (result == ReadStatus::kSuccess)
+        {
+          keyboard.pending = ev;
+        }
+        else
+        {
+          keyboard.readable = false;
+          keyboard.lost = result == ReadStatus::kLost;
+          keyboard_lost |= keyboard.lost;
+        }
+
+        if (metrics_ && keyboard.source->syn_dropped() != keyboard.syn_dropped)
+        {
+          metrics_->syn_dropped.add(keyboard.source->syn_dropped() - keyboard.syn_dropped);
+          keyboard.syn_dropped = keyboard.source->syn_dropped();
+        }
+      }
+
+      if (keyboard.pending && (!first_time || eventTime(*keyboard.pending) < *first_time))
+      {
+        first_time = eventTime(*keyboard.pending);
+        first_keyboard = &keyboard;
+      }
+    }
+
+    if (!first_time || *first_time >= limit)
+      break;
+
+    if (first_keyboard)
+    {
+      if (!handleKeyboardEvent(*first_keyboard))
+      {
+        return false;
+      }
+      continue;
+    }
+
+    Frame frame = mouse_frame_;
+    mouse_frame_ = Frame{};
+    if (!handleMouseFrame(frame))
+    {
+      return false;
+    }
+  }
+
+  if (keyboard_lost)
+  {
+    for (auto it = keyboards_.begin(); it != keyboards_.end();)
+    {
+      if (!it->lost)
+      {
+        ++it;
+        continue;
+      }
+
+      SPDLOG_WARN("Keyboard device lost");
+      router_.removeKeyboard(it->num_passthrough);
+      it = keyboards_.erase(it);
+    }
+    setFds();
+  }
+
+  if (mouse_lost)
+  {
+    SPDLOG_ERROR("Mouse device lost");
+    return false;
+  }
+
+  return true;
+}
+
+bool EventLoop::handleKeyboardEvent(Keyboard& keyboard)
+{
+  ev_ = *keyboard.pending;
+  keyboard.pending.reset();
+
+  std::chrono::microseconds time = eventTime(ev_);
+  clock_.onInput(time);
+  if (metrics_)
+  {
+    metrics_->keyboard_events.add();
+  }
+
+  // As with mouse frames, ticks that fell due before the event run first.
+  if (auto next_tick_time = router_.next_tick_time(); next_tick_time && time > *next_tick_time)
+  {
+    if (!tick(time))
+    {
+      return false;
+    }
+  }
+
+  router_.handleKeyboardEvent(ev_, keyboard.num_passthrough);
+  return true;
+}
+
+bool EventLoop::handleMouseFrame(const Frame& frame)
+{
+  ev_ = frame.events[frame.count - 1];
+  std::chrono::microseconds frame_time = eventTime(ev_);
+  clock_.onInput(frame_time);
+  if (metrics_)
+  {
+    metrics_->mouse_events.add(frame.count);
+  }
+
+  // Ticks that fell due before this frame run first. A loop that keeps up never sees such a frame; one that reads a
+  // backlog, such as a loop on a virtual clock, would otherwise run them all as one late tick after the backlog.
+  if (auto next_tick_time = router_.next_tick_time(); next_tick_time && frame_time > *next_tick_time)
+  {
+    if (!tick(frame_time))
+    {
+      return false;
+    }
+  }
+
+  if (calibrator_ && calibrator_->onFrame(frame.events, frame.count))
+  {
+    calibrator_ = nullptr;
+  }
+
+  if (shadow_)
+  {
+    shadow_->push(frame.events, frame.count);
+  }
+
+  // Plain pointer motion while idle goes straight from the read buffer to the output.
+  if (router_.canForward(frame.events, frame.count))
+  {
+    bool ok = output_.write(frame.events, frame.count);
+    SMOOTH_SCROLL_PROBE3(write_events, ev_.time.tv_sec * 1'000'000 + ev_.time.tv_usec, frame.count, ok);
+    if (!ok)
+    {
+      return false;
+    }
+
+    if (metrics_)
+    {
+      metrics_->output_frames.add();
+      metrics_->output_events.add(frame.count);
+      metrics_->observeLatency(clock_.now() - frame_time);
+    }
+    return true;
+  }
+
+  for (size_t i = 0; i < frame.count; ++i)
+  {
+    router_.handleMouseEvent(frame.events[i]);
+  }
+
+  if (journal_ || metrics_)
+  {
+    recordSession();
+
+    if (router_.next_tick_time())
+    {
+      session_latency_ = std::max(session_latency_, clock_.now() - frame_time);
+    }
+  }
+
+  if (!writeOutput())
+  {
+    return false;
+  }
+
+  if (metrics_)
+  {
+    metrics_->observeLatency(clock_.now() - frame_time);
+  }
+
+  return true;
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <sys/select.h>
+
+#include "clock.h"
+#include "device_calibrator.h"
+#include "event_router.h"
+#include "io_backend.h"
+#include "ipc_server.h"
+#include "metrics.h"
+#include "output_queue.h"
+#include "realtime.h"
+#include "session_journal.h"
+#include "shadow_smoother.h"
+#include "tick_tracer.h"
+
+namespace smooth_scroll
+{
+
+// The daemon's main loop: waits on the mouse and keyboard sources, feeds their events to an EventRouter, runs its
+// ticks on time, writes the resulting frames to the output sink and mirrors the router's state to IPC. It knows
+// nothing about where events come from, so it runs the same on real devices and on in-memory pipes, and it reads the
+// time and waits for ticks through a Clock, so on a VirtualClock it runs as fast as it can.
+class EventLoop
+{
+public:
+  struct Options : EventRouter::Options
+  {
+    // Timer slack while scrolling, 0 to leave it alone.
+    unsigned long scroll_timer_slack_ns = 0;
+  };
+
+  // With `wheel_output`, wheel frames the router splits off (see EventRouter::Options::split_wheel_output) go there
+  // through a queue of their own, so neither stream ever waits behind the other.
+  EventLoop(const Options& options, const WheelSmoother::Options& smoother_options, IpcServer& ipc,
+            InputSource& mouse, std::vector<std::unique_ptr<InputSource>> keyboards, OutputSink& output,
+            OutputSink* wheel_output = nullptr, Clock& clock = SystemClock::instance());
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  // Runs until `shutdown` is set (returns true) or until the mouse is lost or output fails (returns false).
+  bool run(const std::atomic_bool& shutdown);
+
+  // Feeds mouse frames to `calibrator` until it has what it needs.
+  void setCalibrator(DeviceCalibrator* calibrator) noexcept
+  {
+    calibrator_ = calibrator;
+  }
+
+  // Copies every mouse frame to `shadow`.
+  void setShadow(ShadowSmoother* shadow) noexcept
+  {
+    shadow_ = shadow;
+  }
+
+  // Appends every scroll session that ends to `journal`.
+  void setJournal(SessionJournal* journal) noexcept
+  {
+    journal_ = journal;
+  }
+
+  // Counts what the loop does in `metrics`.
+  void setMetrics(Metrics* metrics) noexcept
+  {
+    metrics_ = metrics;
+  }
+
+private:
+  struct Keyboard
+  {
+    std::unique_ptr<InputSource> source;
+    int num_passthrough;
+    uint64_t syn_dropped;  // already counted in metrics_
+    bool readable;  // select() found it readable and it has not run dry since
+    bool lost;
+    std::optional<struct input_event> pending;  // read ahead, not handled yet
+  };
+
+  void setFds() noexcept;
+
+  bool writeOutput() noexcept;
+
+  bool writeFrames(OutputQueue& queue, const std::vector<struct input_event>& events) noexcept;
+
+  OutputQueue& wheelQueue() noexcept
+  {
+    return wheel_output_ ? *wheel_output_ : output_;
+  }
+
+  void publishState() noexcept;
+
+  void recordSession() noexcept;
+
+  void updateMetrics() noexcept;
+
+  // Runs the ticks due at `now`.
+  bool tick(std::chrono::microseconds now);
+
+  // Handles the input read ahead and what the readable sources hold, up to input stamped `limit`, in timestamp order
+  // across the sources. Returns false if the mouse is lost or output fails.
+  bool handleInput(const fd_set& read_fds, std::chrono::microseconds limit);
+
+  bool handleKeyboardEvent(Keyboard& keyboard);
+
+  bool handleMouseFrame(const Frame& frame);
+
+  Clock& clock_;
+  IpcServer& ipc_;
+  InputSource& mouse_;
+  std::vector<Keyboard> keyboards_;
+  OutputQueue output_;
+  std::optional<OutputQueue> wheel_output_;
+
+  EventRouter router_;
+  EventRouter::State published_state_;
+  TickTracer tick_tracer_;
+  TimerSlack timer_slack_;
+  DeviceCalibrator* calibrator_ = nullptr;
+  ShadowSmoother* shadow_ = nullptr;
+  SessionJournal* journal_ = nullptr;
+  std::chrono::microseconds session_latency_{ 0 };
+  Metrics* metrics_ = nullptr;
+  uint64_t mouse_syn_dropped_ = 0;  // already counted in metrics_
+  std::optional<std::chrono::microseconds> passthrough_start_;
+
+  int max_fd_ = -1;
+  fd_set fds_;
+  bool mouse_readable_ = false;
+  Frame mouse_frame_;  // read ahead, not handled yet, while count != 0
+
+  struct input_event ev_ {};
+};
+
+}  // namespace smooth_scroll
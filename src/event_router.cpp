@@ -0,0 +1,376 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "event_router.h"
+
+#include "probes.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace smooth_scroll
+{
+
+EventRouter::EventRouter(const Options& options, const WheelSmoother::Options& smoother_options)
+  : options_{ options }, wheel_smoother_{ smoother_options }
+{
+  // Passthrough keys brake as well.
+  for (auto key : options.keyboard_braking_keys)
+  {
+    if (key < KEY_CNT)
+      braking_keys_table_[key] = true;
+  }
+
+  for (auto key : options.keyboard_passthrough_keys)
+  {
+    if (key < KEY_CNT)
+    {
+      braking_keys_table_[key] = true;
+      passthrough_keys_table_[key] = true;
+    }
+  }
+
+  // A whole frame from a source, then the frame plus its SYN_REPORT and a frame of wheel events, fit without growing.
+  frame_.reserve(kMaxFrameEvents);
+  output_.reserve(kMaxFrameEvents + 8);
+  if (options.split_wheel_output)
+  {
+    // Wheel events of every code, drag view motion and legacy notches for both axes, then that frame and two of
+    // smoothed output.
+    wheel_frame_.reserve(16);
+    wheel_output_.reserve(32);
+  }
+}
+
+void EventRouter::brake(ProbeStopReason reason) noexcept
+{
+  wheel_smoother_.stop(reason);
+}
+
+void EventRouter::setForcePassthrough(bool force_passthrough) noexcept
+{
+  force_passthrough_ = force_passthrough;
+}
+
+void EventRouter::handleMouseEvent(const struct input_event& ev)
+{
+  // Ticks that fell due before the event run first, so that the event changes the scroll from where it actually is.
+  // Without an output period the host has run them already.
+  if (options_.output_period_microseconds > 0)
+  {
+    auto event_time = std::chrono::seconds{ ev.time.tv_sec } + std::chrono::microseconds{ ev.time.tv_usec };
+    accumulateTicks(wheel_smoother_.dueTicks(event_time - std::chrono::microseconds{ 1 }));
+  }
+
+  switch (ev.type)
+  {
+    case EV_REL:
+      switch (ev.code)
+      {
+        case REL_WHEEL:
+        case REL_HWHEEL:
+          if (passthrough())
+          {
+            wheelFrame().push_back(ev);
+          }
+          else
+          {
+            (ev.code == REL_HWHEEL ? frame_horizontal_notches_ : frame_notches_) += ev.value;
+          }
+          break;
+
+        case REL_WHEEL_HI_RES:
+        case REL_HWHEEL_HI_RES:
+          if (passthrough())
+          {
+            wheelFrame().push_back(ev);
+          }
+          break;
+
+        case REL_X:
+        case REL_Y: {
+          handleFrameNotches(ev.time);
+
+          struct input_event motion = ev;
+          if (ev.code == REL_X)
+          {
+            wheel_smoother_.handleRelXEvent(motion);
+          }
+          else
+          {
+            wheel_smoother_.handleRelYEvent(motion);
+          }
+
+          // In drag view the smoother turns motion into wheel events, which go wherever the wheel's own do.
+          (motion.code == ev.code ? frame_ : wheelFrame()).push_back(motion);
+          break;
+        }
+
+        default:
+          frame_.push_back(ev);
+          break;
+      }
+      break;
+
+    case EV_KEY: {
+      handleFrameNotches(ev.time);
+      bool handled = false;
+
+      if (ev.code == options_.drag_view_button)
+      {
+        handled = wheel_smoother_.handleDragViewButton(ev.value);
+      }
+      else if (ev.code == options_.free_spin_button)
+      {
+        handled = wheel_smoother_.handleFreeSpinButton(ev.value);
+      }
+
+      if (!handled)
+      {
+        wheel_smoother_.stop(ProbeStopReason::kClick);
+        frame_.push_back(ev);
+      }
+      break;
+    }
+
+    case EV_MSC:
+      break;
+
+    case EV_SYN:
+      if (ev.code == SYN_REPORT)
+      {
+        handleFrameNotches(ev.time);
+        wheel_smoother_.handleReportEvent(ev.time);
+
+        if (!frame_.empty())
+        {
+          output_.insert(output_.end(), frame_.begin(), frame_.end());
+          output_.push_back({ ev.time, EV_SYN, SYN_REPORT, 0 });
+          frame_.clear();
+        }
+
+        if (!wheel_frame_.empty())
+        {
+          wheel_output_.insert(wheel_output_.end(), wheel_frame_.begin(), wheel_frame_.end());
+          wheel_output_.push_back({ ev.time, EV_SYN, SYN_REPORT, 0 });
+          wheel_frame_.clear();
+        }
+      }
+      break;
+
+    default:
+      frame_.push_back(ev);
+      break;
+  }
+}
+
+void EventRouter::handleFrameNotches(const struct timeval& time)
+{
+  // In code order, as the kernel reports them.
+  for (bool horizontal : { true, false })
+  {
+    int& notches = horizontal ? frame_horizontal_notches_ : frame_notches_;
+    if (notches == 0)
+      continue;
+
+    if (auto ev_wheel = wheel_smoother_.handleEvent(time, notches > 0, horizontal, std::abs(notches)))
+    {
+      appendWheel(wheelFrame(), *ev_wheel);
+    }
+    notches = 0;
+  }
+}
+
+bool EventRouter::canForward(const struct input_event* events, size_t count) const noexcept
+{
+  if (count < 2 || !frame_.empty() || next_tick_time() ||
+      wheel_smoother_.drag_view())
+    return false;
+
+  if (events[count - 1].type != EV_SYN || events[count - 1].code != SYN_REPORT)
+    return false;
+
+  const bool wheel = passthrough() && !options_.split_wheel_output;
+  for (size_t i = 0; i < count - 1; ++i)
+  {
+    if (events[i].type != EV_REL)
+      return false;
+
+    switch (events[i].code)
+    {
+      case REL_WHEEL:
+      case REL_HWHEEL:
+      case REL_WHEEL_HI_RES:
+      case REL_HWHEEL_HI_RES:
+        if (!wheel)
+          return false;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
+void EventRouter::handleKeyboardEvent(const struct input_event& ev, int& held) noexcept
+{
+  if (ev.type != EV_KEY || ev.code >= KEY_CNT || ev.value == 2)
+    return;
+
+  if (braking_keys_table_[ev.code])
+  {
+    brake(ProbeStopReason::kKeyboard);
+  }
+
+  if (passthrough_keys_table_[ev.code])
+  {
+    if (ev.value == 1)
+    {
+      ++held;
+      ++num_passthrough_;
+    }
+    else
+    {
+      if (held)
+      {
+        --held;
+        --num_passthrough_;
+      }
+    }
+    SMOOTH_SCROLL_PROBE1(passthrough, num_passthrough_);
+  }
+}
+
+void EventRouter::removeKeyboard(int held) noexcept
+{
+  num_passthrough_ -= held;
+  SMOOTH_SCROLL_PROBE1(passthrough, num_passthrough_);
+}
+
+bool EventRouter::tick(std::chrono::microseconds now)
+{
+  if (force_passthrough_)
+  {
+    wheel_smoother_.stop(ProbeStopReason::kPassthrough);
+    return flushWheel();
+  }
+
+  if (options_.output_period_microseconds > 0)
+  {
+    int ticks = wheel_smoother_.dueTicks(now);
+    accumulateTicks(ticks == 0 && !pending_wheel_ ? 1 : ticks);
+    return flushWheel();
+  }
+
+  auto ev_wheel = wheel_smoother_.tick(std::max(wheel_smoother_.dueTicks(now), 1));
+  if (!ev_wheel)
+  {
+    return false;
+  }
+
+  appendWheel(wheelOutput(), *ev_wheel);
+  wheelOutput().push_back({ ev_wheel->time, EV_SYN, SYN_REPORT, 0 });
+  return true;
+}
+
+std::optional<std::chrono::microseconds> EventRouter::nextOutputTime(
+    std::optional<std::chrono::microseconds> tick_time) const noexcept
+{
+  if (!tick_time)
+  {
+    // Stopped with output still waiting.
+    if (!pending_wheel_)
+      return std::nullopt;
+
+    const auto& time = pending_wheel_->time;
+    tick_time = std::chrono::seconds{ time.tv_sec } + std::chrono::microseconds{ time.tv_usec };
+  }
+
+  std::chrono::microseconds period{ options_.output_period_microseconds };
+  std::chrono::microseconds phase{ options_.output_phase_microseconds % options_.output_period_microseconds };
+  auto periods = (*tick_time - phase + period - std::chrono::microseconds{ 1 }) / period;
+  return phase + period * periods;
+}
+
+void EventRouter::accumulateTicks(int ticks)
+{
+  if (ticks == 0)
+    return;
+
+  auto ev_wheel = wheel_smoother_.tick(ticks);
+  if (!ev_wheel)
+    return;
+
+  // A scroll on the other axis is never summed with this one.
+  if (pending_wheel_ && pending_wheel_->code != ev_wheel->code)
+  {
+    flushWheel();
+  }
+
+  if (pending_wheel_)
+  {
+    pending_wheel_->value += ev_wheel->value;
+    pending_wheel_->time = ev_wheel->time;
+  }
+  else
+  {
+    pending_wheel_ = ev_wheel;
+  }
+}
+
+bool EventRouter::flushWheel()
+{
+  if (!pending_wheel_)
+    return false;
+
+  auto ev_wheel = *pending_wheel_;
+  pending_wheel_.reset();
+  if (ev_wheel.value == 0)
+    return false;
+
+  appendWheel(wheelOutput(), ev_wheel);
+  wheelOutput().push_back({ ev_wheel.time, EV_SYN, SYN_REPORT, 0 });
+  return true;
+}
+
+void EventRouter::appendWheel(std::vector<struct input_event>& frame, const struct input_event& ev)
+{
+  frame.push_back(ev);
+
+  if (!options_.legacy_wheel_events)
+    return;
+
+  // The remainder is kept across scrolls but dropped on a change of axis or direction, like the kernel's own
+  // hi-res to legacy conversion.
+  __u16 code = ev.code == REL_HWHEEL_HI_RES ? REL_HWHEEL : REL_WHEEL;
+  if (code != legacy_code_ || (legacy_remainder_ > 0) != (ev.value > 0))
+  {
+    legacy_code_ = code;
+    legacy_remainder_ = 0;
+  }
+
+  legacy_remainder_ += ev.value;
+
+  int notches = legacy_remainder_ / 120;
+  if (notches != 0)
+  {
+    legacy_remainder_ -= notches * 120;
+    frame.push_back({ ev.time, EV_REL, code, notches });
+  }
+}
+
+EventRouter::State EventRouter::state() const noexcept
+{
+  State state;
+  state.speed = wheel_smoother_.speed();
+  state.positive = wheel_smoother_.positive();
+  state.horizontal = wheel_smoother_.horizontal();
+  state.drag_view = wheel_smoother_.drag_view();
+  state.free_spin = wheel_smoother_.free_spin();
+  state.passthrough = num_passthrough_;
+  return state;
+}
+
+}  // namespace smooth_scroll
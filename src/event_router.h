@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include <linux/input.h>
+
+#include "io_backend.h"
+#include "wheel_smoother.h"
+
+namespace smooth_scroll
+{
+
+// Routes one mouse's events and any number of keyboards' events through WheelSmoother and collects the resulting
+// frames. It does no I/O and keeps no clock: the host feeds events as they arrive, runs tick() when
+// next_tick_time() is reached and drains output(). The daemon's EventLoop and the C API in smoothscroll.h are both
+// hosts of this class.
+class EventRouter
+{
+public:
+  struct Options
+  {
+    int free_spin_button = BTN_RIGHT;
+    int drag_view_button = BTN_LEFT;
+    std::vector<unsigned int> keyboard_braking_keys;
+    std::vector<unsigned int> keyboard_passthrough_keys;
+
+    // Also emit a REL_WHEEL/REL_HWHEEL notch for every 120 hi-res units of smoothed scrolling, in the same frame,
+    // for clients that only read the legacy wheel.
+    bool legacy_wheel_events = false;
+
+    // Emit smoothed scrolling once per this many microseconds instead of once per tick, for example once per
+    // display refresh. The smoother still runs every tick and each output frame carries the sum of the ticks since
+    // the last one. 0 to emit every tick.
+    int output_period_microseconds = 0;
+
+    // Output times are this far past a multiple of the period, counted from the epoch of event timestamps.
+    int output_phase_microseconds = 0;
+
+    // Collect wheel events, smoothed or passed through, in wheel_output() instead of output(), for a host that
+    // writes them to a device of their own. output() then holds pointer and button frames exactly as they came in.
+    bool split_wheel_output = false;
+  };
+
+  struct State
+  {
+    double speed = 0;
+    bool positive = false;
+    bool horizontal = false;
+    bool drag_view = false;
+    bool free_spin = false;
+    int passthrough = 0;  // passthrough keys held on all keyboards
+
+    bool operator==(const State& other) const noexcept
+    {
+      return speed == other.speed && positive == other.positive && horizontal == other.horizontal &&
+             drag_view == other.drag_view && free_spin == other.free_spin && passthrough == other.passthrough;
+    }
+
+    bool operator!=(const State& other) const noexcept
+    {
+      return !(*this == other);
+    }
+  };
+
+  EventRouter(const Options& options, const WheelSmoother::Options& smoother_options);
+
+  EventRouter(const EventRouter&) = delete;
+  EventRouter& operator=(const EventRouter&) = delete;
+
+  // Stops the current scroll.
+  void brake(ProbeStopReason reason = ProbeStopReason::kExternal) noexcept;
+
+  // While set, wheel events pass through unsmoothed and the current scroll is stopped at its next tick.
+  void setForcePassthrough(bool force_passthrough) noexcept;
+
+  void handleMouseEvent(const struct input_event& ev);
+
+  // Whether a complete mouse frame can be written out as is instead of going through handleMouseEvent(): nothing
+  // is scrolling or dragging, no frame is half built, and the frame holds only relative motion (and wheel events
+  // while passing through, unless they are split off). Such frames would come out of handleMouseEvent() unchanged and
+  // leave no state behind.
+  [[nodiscard]] bool canForward(const struct input_event* events, size_t count) const noexcept;
+
+  // `held` is the number of passthrough keys held on the keyboard the event came from. It belongs to the caller
+  // so that removeKeyboard() can release them if the keyboard disappears.
+  void handleKeyboardEvent(const struct input_event& ev, int& held) noexcept;
+
+  void removeKeyboard(int held) noexcept;
+
+  // Runs every tick due at `now`, and at least the one scheduled at next_tick_time(), producing one frame with their
+  // summed output so a late wakeup catches up at once. Returns whether it produced a frame.
+  bool tick(std::chrono::microseconds now);
+
+  // With an output period, the output time that follows the smoother's next tick.
+  [[nodiscard]] std::optional<std::chrono::microseconds> next_tick_time() const noexcept
+  {
+    auto time = wheel_smoother_.next_tick_time();
+    if (options_.output_period_microseconds > 0)
+      return nextOutputTime(time);
+
+    return time;
+  }
+
+  [[nodiscard]] State state() const noexcept;
+
+  // The last scroll that ended since the previous call, if any.
+  [[nodiscard]] std::optional<ScrollSession> takeEndedSession() noexcept
+  {
+    return wheel_smoother_.takeEndedSession();
+  }
+
+  // Complete frames, each ending in SYN_REPORT, in the order they were produced.
+  [[nodiscard]] const std::vector<struct input_event>& output() const noexcept
+  {
+    return output_;
+  }
+
+  // Wheel frames, with split_wheel_output set.
+  [[nodiscard]] const std::vector<struct input_event>& wheel_output() const noexcept
+  {
+    return wheel_output_;
+  }
+
+  // Clears both outputs.
+  void clearOutput() noexcept
+  {
+    output_.clear();
+    wheel_output_.clear();
+  }
+
+private:
+  bool passthrough() const noexcept
+  {
+    return num_passthrough_ || force_passthrough_;
+  }
+
+  // Hands the notches collected from the frame so far to the smoother, one call per axis. Runs at the end of the
+  // frame, and before any pointer motion or button in it, so that braking sees the notches and those events in the
+  // order the mouse sent them.
+  void handleFrameNotches(const struct timeval& time);
+
+  // Where wheel events of the mouse frame being built go.
+  std::vector<struct input_event>& wheelFrame() noexcept
+  {
+    return options_.split_wheel_output ? wheel_frame_ : frame_;
+  }
+
+  // Where frames of smoothed wheel events go.
+  std::vector<struct input_event>& wheelOutput() noexcept
+  {
+    return options_.split_wheel_output ? wheel_output_ : output_;
+  }
+
+  // Appends a smoothed hi-res wheel event to `frame`, followed by any legacy notches it completes.
+  void appendWheel(std::vector<struct input_event>& frame, const struct input_event& ev);
+
+  std::optional<std::chrono::microseconds> nextOutputTime(
+      std::optional<std::chrono::microseconds> tick_time) const noexcept;
+
+  // Runs `ticks` ticks into the sum waiting for the next output time.
+  void accumulateTicks(int ticks);
+
+  // Writes the waiting sum out as a frame. Returns whether it produced one.
+  bool flushWheel();
+
+  Options options_;
+#ifdef SMOOTH_SCROLL_FIXED_POINT
+  FixedWheelSmoother wheel_smoother_;
+#else
+  WheelSmoother wheel_smoother_;
+#endif
+
+  bool force_passthrough_ = false;
+  int num_passthrough_ = 0;
+  std::array<bool, KEY_CNT> braking_keys_table_{};
+  std::array<bool, KEY_CNT> passthrough_keys_table_{};
+
+  // Hi-res units emitted since the last legacy notch, on `legacy_code_`.
+  int legacy_remainder_ = 0;
+  __u16 legacy_code_ = REL_WHEEL;
+
+  // Net REL_WHEEL and REL_HWHEEL notches of the frame being built.
+  int frame_notches_ = 0;
+  int frame_horizontal_notches_ = 0;
+
+  // Smoothed scrolling waiting for the next output time, stamped with the last tick it includes.
+  std::optional<struct input_event> pending_wheel_;
+
+  std::vector<struct input_event> frame_;
+  std::vector<struct input_event> output_;
+  std::vector<struct input_event> wheel_frame_;
+  std::vector<struct input_event> wheel_output_;
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "frame_reader.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+FrameReader::FrameReader(int fd) noexcept : fd_(fd)
+{
+}
+
+ReadStatus FrameReader::next(Frame& frame) noexcept
+{
+  while (true)
+  {
+    const struct input_event* begin = buffer_ + head_ / sizeof(struct input_event);
+    size_t available = (tail_ - head_) / sizeof(struct input_event);
+    bool rescan = false;
+
+    for (; scanned_ < available; ++scanned_)
+    {
+      const auto& ev = begin[scanned_];
+
+      if (ev.type == EV_KEY)
+      {
+        frame_has_keys_ = true;
+      }
+      else if (ev.type == EV_SYN && ev.code == SYN_DROPPED)
+      {
+        dropping_ = true;
+        ++syn_dropped_;
+      }
+      else if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+      {
+        size_t count = scanned_ + 1;
+        bool has_keys = frame_has_keys_;
+
+        head_ += count * sizeof(struct input_event);
+        scanned_ = 0;
+        frame_has_keys_ = false;
+
+        if (dropping_)
+        {
+          dropping_ = false;
+          if (resync(ev.time))
+          {
+            frame = Frame{ sync_, sync_size_ };
+            return ReadStatus::kSuccess;
+          }
+          rescan = true;
+          break;
+        }
+
+        if (has_keys)
+        {
+          for (size_t i = 0; i < count; ++i)
+          {
+            if (begin[i].type == EV_KEY && begin[i].code < KEY_CNT && begin[i].value != 2)
+            {
+              keys_[begin[i].code] = begin[i].value;
+            }
+          }
+        }
+
+        frame = Frame{ begin, count };
+        return ReadStatus::kSuccess;
+      }
+    }
+
+    if (rescan)
+      continue;
+
+    // A frame longer than the whole buffer is handed out in pieces.
+    if (head_ == 0 && tail_ / sizeof(struct input_event) == kMaxFrameEvents && !dropping_)
+    {
+      head_ = tail_;
+      scanned_ = 0;
+      frame_has_keys_ = false;
+      frame = Frame{ begin, available };
+      return ReadStatus::kSuccess;
+    }
+
+    if (dropping_)
+    {
+      // Nothing before the next SYN_REPORT is kept.
+      head_ += available * sizeof(struct input_event);
+      scanned_ = 0;
+    }
+
+    auto status = fill();
+    if (status != ReadStatus::kSuccess)
+      return status;
+  }
+}
+
+ReadStatus FrameReader::nextEvent(struct input_event& ev) noexcept
+{
+  if (event_it_ == event_end_)
+  {
+    Frame frame;
+    auto status = next(frame);
+    if (status != ReadStatus::kSuccess)
+      return status;
+
+    event_it_ = frame.events;
+    event_end_ = frame.events + frame.count;
+  }
+
+  ev = *event_it_++;
+  return ReadStatus::kSuccess;
+}
+
+ReadStatus FrameReader::fill() noexcept
+{
+  char* const buffer = reinterpret_cast<char*>(buffer_);
+
+  // Keep the unfinished frame at the front and refill behind it.
+  std::memmove(buffer, buffer + head_, tail_ - head_);
+  tail_ -= head_;
+  head_ = 0;
+
+  while (true)
+  {
+    ssize_t n = read(fd_, buffer + tail_, sizeof(buffer_) - tail_);
+    if (n > 0)
+    {
+      tail_ += n;
+      return ReadStatus::kSuccess;
+    }
+
+    if (n < 0 && errno == EINTR)
+      continue;
+
+    if (n < 0 && errno == EAGAIN)
+      return ReadStatus::kAgain;
+
+    // End of file, the device unplugged (ENODEV) or any other error: a source that fails to read once would only
+    // fail again, with select() reporting it readable every time.
+    if (n < 0 && errno != ENODEV)
+    {
+      SPDLOG_ERROR("Failed to read input events: {}", strerror(errno));
+    }
+    return ReadStatus::kLost;
+  }
+}
+
+bool FrameReader::resync(const struct timeval& time)
+{
+  constexpr size_t kLongBits = sizeof(unsigned long) * CHAR_BIT;
+  unsigned long bits[(KEY_CNT + kLongBits - 1) / kLongBits] = {};
+
+  if (ioctl(fd_, EVIOCGKEY(sizeof(bits)), bits) < 0)
+    return false;
+
+  sync_size_ = 0;
+  for (unsigned int code = 0; code < KEY_CNT; ++code)
+  {
+    bool pressed = (bits[code / kLongBits] >> (code % kLongBits)) & 1;
+    if (pressed != keys_[code])
+    {
+      keys_[code] = pressed;
+      sync_[sync_size_++] = { time, EV_KEY, static_cast<__u16>(code), pressed ? 1 : 0 };
+    }
+  }
+
+  if (sync_size_ == 0)
+    return false;
+
+  sync_[sync_size_++] = { time, EV_SYN, SYN_REPORT, 0 };
+  return true;
+}
+
+}  // namespace smooth_scroll
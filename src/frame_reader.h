@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+
+#include "io_backend.h"
+
+namespace smooth_scroll
+{
+
+// Reads raw input_event structs from a non-blocking fd in large chunks and hands them out a frame at a time,
+// straight from its buffer. After SYN_DROPPED it discards events through the next SYN_REPORT and, when the fd is an
+// evdev device, returns a frame of key events that brings the button state seen by the consumer back in line with
+// the device.
+class FrameReader
+{
+public:
+  explicit FrameReader(int fd) noexcept;
+
+  FrameReader(const FrameReader&) = delete;
+  FrameReader& operator=(const FrameReader&) = delete;
+
+  ReadStatus next(Frame& frame) noexcept;
+
+  // Hands out the events of next() one at a time.
+  ReadStatus nextEvent(struct input_event& ev) noexcept;
+
+  // How many times the kernel reported dropped events.
+  [[nodiscard]] uint64_t syn_dropped() const noexcept
+  {
+    return syn_dropped_;
+  }
+
+private:
+  // Reads more events behind the unfinished frame. Only EAGAIN is worth waiting on; any other failure is kLost.
+  ReadStatus fill() noexcept;
+
+  bool resync(const struct timeval& time);
+
+  int fd_;
+  struct input_event buffer_[kMaxFrameEvents];
+  size_t head_ = 0;  // bytes
+  size_t tail_ = 0;  // bytes
+  size_t scanned_ = 0;  // events after head_ already scanned for the end of the frame
+  bool frame_has_keys_ = false;
+  bool dropping_ = false;
+  uint64_t syn_dropped_ = 0;
+
+  std::bitset<KEY_CNT> keys_;
+  struct input_event sync_[KEY_CNT + 1];  // one event per key and a SYN_REPORT
+  size_t sync_size_ = 0;
+
+  const struct input_event* event_it_ = nullptr;
+  const struct input_event* event_end_ = nullptr;
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/input.h>
+
+namespace smooth_scroll
+{
+
+enum class ReadStatus
+{
+  kSuccess,  // An event was read.
+  kAgain,    // No more events right now; wait for fd() to become readable.
+  kLost,     // The device is gone, or reading it failed.
+};
+
+// Sources hand out frames of at most this many events; longer frames arrive in pieces. Buffers sized for it hold
+// any frame without growing.
+constexpr size_t kMaxFrameEvents = 256;
+
+// Events up to and including a SYN_REPORT, pointing into a source's read buffer.
+struct Frame
+{
+  const struct input_event* events = nullptr;
+  size_t count = 0;
+};
+
+// A source of input events the event loop can wait on with select(). A source is read either event by event with
+// next() or frame by frame with nextFrame(), never both.
+class InputSource
+{
+public:
+  virtual ~InputSource() = default;
+
+  [[nodiscard]] virtual int fd() const noexcept = 0;
+
+  // Reads the next pending event. Implementations recover from dropped events on their own and only report what
+  // the loop should act on.
+  virtual ReadStatus next(struct input_event& ev) noexcept = 0;
+
+  // Reads the next complete frame without copying it. The events stay valid until the next call.
+  virtual ReadStatus nextFrame(Frame& frame) noexcept = 0;
+
+  // How many times the source reported dropped events so far.
+  [[nodiscard]] virtual uint64_t syn_dropped() const noexcept
+  {
+    return 0;
+  }
+};
+
+enum class WriteStatus
+{
+  kSuccess,  // Everything was written.
+  kAgain,    // The sink is full; wait for fd() to become writable and write the rest.
+  kFailed,   // The sink is broken.
+};
+
+// Receives the frames the event loop produces. Every call carries one complete frame ending in SYN_REPORT, or the
+// unwritten tail of one.
+class OutputSink
+{
+public:
+  virtual ~OutputSink() = default;
+
+  // The fd to wait on after kAgain, or -1 if the sink never returns it.
+  [[nodiscard]] virtual int fd() const noexcept = 0;
+
+  // `written` is set to the number of leading events that went out.
+  virtual WriteStatus write(const struct input_event* events, size_t count, size_t& written) noexcept = 0;
+};
+
+}  // namespace smooth_scroll
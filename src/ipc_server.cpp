@@ -63,9 +63,9 @@ bool IpcServer::initialize()
   mapped_memory_->state_bits.store(0, std::memory_order_relaxed);
   mapped_memory_->scroll_id.store(0, std::memory_order_relaxed);
   mapped_memory_->force_passthrough.store(0, std::memory_order_relaxed);
+  mapped_memory_->tick_trace.store(0, std::memory_order_relaxed);
   mapped_memory_->reserved[0].store(0, std::memory_order_relaxed);
   mapped_memory_->reserved[1].store(0, std::memory_order_relaxed);
-  mapped_memory_->reserved[2].store(0, std::memory_order_relaxed);
 
   mapped_memory_->daemon_pid.store(getpid(), std::memory_order_relaxed);
   mapped_memory_->magic_version.store(MAGIC_VERSION_EXPECTED, std::memory_order_release);
@@ -176,4 +176,11 @@ void IpcServer::setSpeed(double speed, bool positive, bool horizontal) noexcept
   return mapped_memory_->force_passthrough.load(std::memory_order_relaxed) > 0;
 }
 
+[[nodiscard]] bool IpcServer::isTickTraceEnabled() const noexcept
+{
+  assert(mapped_memory_);
+
+  return mapped_memory_->tick_trace.load(std::memory_order_relaxed) > 0;
+}
+
 }  // namespace smooth_scroll
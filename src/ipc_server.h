@@ -18,7 +18,8 @@ struct alignas(32) SmoothScrollIPC
   std::atomic<uint32_t> state_bits;
   std::atomic<uint32_t> scroll_id;
   std::atomic<uint32_t> force_passthrough;
-  std::atomic<uint32_t> reserved[3];
+  std::atomic<uint32_t> tick_trace;
+  std::atomic<uint32_t> reserved[2];
 };
 
 static_assert(sizeof(SmoothScrollIPC) == 32, "IPC struct size must be exactly 32 bytes");
@@ -49,6 +50,8 @@ public:
 
   [[nodiscard]] bool isForcePassthroughEnabled() const noexcept;
 
+  [[nodiscard]] bool isTickTraceEnabled() const noexcept;
+
 private:
   static constexpr uint32_t MAGIC_VERSION_EXPECTED = 0x53530001;
 
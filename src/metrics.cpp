@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include "state_dir.h"
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+void writeMetric(fmt::memory_buffer& out, const char* name, const char* type, const char* help, uint64_t value)
+{
+  fmt::format_to(std::back_inserter(out), "# HELP smooth_scroll_{0} {1}\n# TYPE smooth_scroll_{0} {2}\n"
+                                          "smooth_scroll_{0} {3}\n",
+                 name, help, type, value);
+}
+
+}  // namespace
+
+MetricsWriter::MetricsWriter(const Metrics& metrics, std::string path, std::chrono::seconds interval,
+                             const Clock& clock)
+  : metrics_{ metrics }, path_{ std::move(path) }, interval_{ interval }, clock_{ clock }
+{
+}
+
+MetricsWriter::~MetricsWriter()
+{
+  stop();
+}
+
+void MetricsWriter::start()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_)
+    return;
+
+  running_ = true;
+  thread_ = std::thread(&MetricsWriter::run, this);
+  SPDLOG_INFO("Writing metrics to {} every {}s", path_, interval_.count());
+}
+
+void MetricsWriter::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+      return;
+
+    running_ = false;
+  }
+
+  cv_.notify_one();
+  thread_.join();
+}
+
+void MetricsWriter::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_)
+  {
+    lock.unlock();
+    write();
+    lock.lock();
+
+    cv_.wait_for(lock, interval_, [this] { return !running_; });
+  }
+
+  lock.unlock();
+  write();
+}
+
+void MetricsWriter::write()
+{
+  fmt::memory_buffer out;
+  auto it = std::back_inserter(out);
+
+  // A passthrough still on counts up to now. One that just ended may have its start cleared and its time not added
+  // yet, so the counter never goes below what was written last.
+  uint64_t passthrough_us = metrics_.passthrough_us.load();
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (int64_t start = metrics_.passthrough_start_us.load(std::memory_order_relaxed); start != 0)
+  {
+    passthrough_us += std::max<int64_t>(clock_.now().count() - start, 0);
+  }
+  passthrough_us_ = std::max(passthrough_us_, passthrough_us);
+
+  writeMetric(out, "mouse_events_total", "counter", "Events read from the mouse.", metrics_.mouse_events.load());
+  writeMetric(out, "keyboard_events_total", "counter", "Events read from the keyboards.",
+              metrics_.keyboard_events.load());
+  writeMetric(out, "output_frames_total", "counter", "Frames written to the virtual device.",
+              metrics_.output_frames.load());
+  writeMetric(out, "output_events_total", "counter", "Events written to the virtual device.",
+              metrics_.output_events.load());
+  writeMetric(out, "ticks_total", "counter", "Smoother ticks run.", metrics_.ticks.load());
+  writeMetric(out, "empty_ticks_total", "counter", "Smoother ticks that produced no scroll output.",
+              metrics_.empty_ticks.load());
+  writeMetric(out, "brake_signals_total", "counter", "Brake signals received over IPC.",
+              metrics_.brake_signals.load());
+  writeMetric(out, "syn_dropped_total", "counter", "Times an input device reported dropped events.",
+              metrics_.syn_dropped.load());
+  writeMetric(out, "output_stalls_total", "counter", "Times the virtual device could not take output.",
+              metrics_.output_stalls.load());
+  writeMetric(out, "output_merged_frames_total", "counter", "Frames merged into another while output stalled.",
+              metrics_.output_merged_frames.load());
+  writeMetric(out, "output_dropped_frames_total", "counter", "Frames dropped while output stalled.",
+              metrics_.output_dropped_frames.load());
+  writeMetric(out, "passthrough_microseconds_total", "counter", "Time spent in passthrough.", passthrough_us_);
+  writeMetric(out, "passthrough", "gauge", "Whether scroll events are passed through unsmoothed.",
+              metrics_.passthrough.load(std::memory_order_relaxed));
+  writeMetric(out, "scrolling", "gauge", "Whether the smoother is scrolling.",
+              metrics_.scrolling.load(std::memory_order_relaxed));
+
+  fmt::format_to(it, "# HELP smooth_scroll_stops_total Scroll sessions ended, by reason.\n"
+                     "# TYPE smooth_scroll_stops_total counter\n");
+  for (int reason = 0; reason < kNumStopReasons; ++reason)
+  {
+    fmt::format_to(it, "smooth_scroll_stops_total{{reason=\"{}\"}} {}\n", stopReasonName(reason),
+                   metrics_.stops[reason].load());
+  }
+
+  fmt::format_to(it, "# HELP smooth_scroll_latency_seconds Time from a mouse frame to the output it caused.\n"
+                     "# TYPE smooth_scroll_latency_seconds histogram\n");
+  uint64_t count = 0;
+  for (size_t bucket = 0; bucket < Metrics::kLatencyBounds.size(); ++bucket)
+  {
+    count += metrics_.latency_buckets[bucket].load();
+    fmt::format_to(it, "smooth_scroll_latency_seconds_bucket{{le=\"{}\"}} {}\n",
+                   Metrics::kLatencyBounds[bucket] / 1e6, count);
+  }
+  count += metrics_.latency_buckets.back().load();
+  fmt::format_to(it, "smooth_scroll_latency_seconds_bucket{{le=\"+Inf\"}} {}\n", count);
+  fmt::format_to(it, "smooth_scroll_latency_seconds_sum {}\n", metrics_.latency_sum_us.load() / 1e6);
+  fmt::format_to(it, "smooth_scroll_latency_seconds_count {}\n", count);
+
+  writeStateFile(path_, fmt::to_string(out));
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "clock.h"
+#include "probes.h"
+
+namespace smooth_scroll
+{
+
+// Counters and gauges the event loop updates as it goes. Every value has a single writer, the event loop, so an update
+// is a relaxed load and store with no locked instruction and no syscall; MetricsWriter only reads them.
+struct Metrics
+{
+  class Counter
+  {
+  public:
+    void add(uint64_t n = 1) noexcept
+    {
+      value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // Mirrors a count kept elsewhere.
+    void set(uint64_t value) noexcept
+    {
+      value_.store(value, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t load() const noexcept
+    {
+      return value_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<uint64_t> value_{ 0 };
+  };
+
+  // Upper bounds of the input latency histogram buckets, in microseconds. A last bucket takes the rest.
+  static constexpr std::array<int64_t, 8> kLatencyBounds = { 250, 500, 1'000, 2'000, 4'000, 8'000, 16'000, 32'000 };
+
+  void observeLatency(std::chrono::microseconds latency) noexcept
+  {
+    size_t bucket = 0;
+    while (bucket < kLatencyBounds.size() && latency.count() > kLatencyBounds[bucket])
+    {
+      ++bucket;
+    }
+    latency_buckets[bucket].add();
+    latency_sum_us.add(latency.count() > 0 ? latency.count() : 0);
+  }
+
+  Counter mouse_events;
+  Counter keyboard_events;
+  Counter output_frames;
+  Counter output_events;
+  Counter ticks;
+  Counter empty_ticks;
+  std::array<Counter, kNumStopReasons> stops;
+  Counter brake_signals;
+  Counter syn_dropped;
+  Counter output_stalls;
+  Counter output_merged_frames;
+  Counter output_dropped_frames;
+  Counter passthrough_us;  // of passthrough that has ended
+  // On the loop's clock while passthrough is on, 0 otherwise. Cleared before the time is added to passthrough_us.
+  std::atomic<int64_t> passthrough_start_us{ 0 };
+  std::atomic<bool> passthrough{ false };
+  std::atomic<bool> scrolling{ false };
+  std::array<Counter, kLatencyBounds.size() + 1> latency_buckets;
+  Counter latency_sum_us;
+};
+
+// Writes a Metrics in the Prometheus text format to a file every interval, from its own thread, for node-exporter's
+// textfile collector or anything else that reads it. Each write replaces the file in one rename, so a reader never
+// sees half of one.
+class MetricsWriter
+{
+public:
+  // `clock` is the event loop's, so that a passthrough still on counts up to the time of each write.
+  MetricsWriter(const Metrics& metrics, std::string path, std::chrono::seconds interval,
+                const Clock& clock = SystemClock::instance());
+
+  ~MetricsWriter();
+
+  MetricsWriter(const MetricsWriter&) = delete;
+  MetricsWriter& operator=(const MetricsWriter&) = delete;
+
+  void start();
+
+  // Writes the file a last time and stops.
+  void stop();
+
+private:
+  void run();
+
+  void write();
+
+  const Metrics& metrics_;
+  std::string path_;
+  std::chrono::seconds interval_;
+  const Clock& clock_;
+  uint64_t passthrough_us_ = 0;  // as last written
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_ = false;
+  std::thread thread_;
+};
+
+}  // namespace smooth_scroll
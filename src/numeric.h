@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace smooth_scroll
+{
+
+// Q31.32 fixed point: a 64-bit integer counting units of 2^-32. All arithmetic is integer arithmetic, so results are
+// the same bit for bit on every compiler and architecture, and cheap on cores with a slow FPU. Integers convert
+// implicitly and exactly; doubles only through fromDouble().
+class Fixed
+{
+public:
+  static constexpr int kFractionBits = 32;
+  static constexpr int64_t kOne = int64_t{ 1 } << kFractionBits;
+
+  constexpr Fixed() noexcept = default;
+
+  template <typename Int, typename = std::enable_if_t<std::is_integral_v<Int>>>
+  constexpr Fixed(Int value) noexcept : raw_{ static_cast<int64_t>(value) * kOne }
+  {
+  }
+
+  [[nodiscard]] static constexpr Fixed fromRaw(int64_t raw) noexcept
+  {
+    Fixed fixed;
+    fixed.raw_ = raw;
+    return fixed;
+  }
+
+  // Scaling by a power of two is exact, so this depends only on the double.
+  [[nodiscard]] static Fixed fromDouble(double value) noexcept
+  {
+    return fromRaw(std::llround(value * kOne));
+  }
+
+  [[nodiscard]] constexpr int64_t raw() const noexcept
+  {
+    return raw_;
+  }
+
+  [[nodiscard]] constexpr double toDouble() const noexcept
+  {
+    return static_cast<double>(raw_) / kOne;
+  }
+
+  // Rounds half away from zero, like std::round.
+  [[nodiscard]] constexpr int round() const noexcept
+  {
+    return static_cast<int>(raw_ >= 0 ? (raw_ + kOne / 2) >> kFractionBits : -((-raw_ + kOne / 2) >> kFractionBits));
+  }
+
+  friend constexpr Fixed operator+(Fixed a, Fixed b) noexcept
+  {
+    return fromRaw(a.raw_ + b.raw_);
+  }
+
+  friend constexpr Fixed operator-(Fixed a, Fixed b) noexcept
+  {
+    return fromRaw(a.raw_ - b.raw_);
+  }
+
+  friend constexpr Fixed operator-(Fixed a) noexcept
+  {
+    return fromRaw(-a.raw_);
+  }
+
+  // Rounds toward negative infinity.
+  friend constexpr Fixed operator*(Fixed a, Fixed b) noexcept
+  {
+    return fromRaw(multiply(a.raw_, b.raw_));
+  }
+
+  constexpr Fixed& operator+=(Fixed other) noexcept
+  {
+    raw_ += other.raw_;
+    return *this;
+  }
+
+  constexpr Fixed& operator-=(Fixed other) noexcept
+  {
+    raw_ -= other.raw_;
+    return *this;
+  }
+
+  constexpr Fixed& operator*=(Fixed other) noexcept
+  {
+    raw_ = multiply(raw_, other.raw_);
+    return *this;
+  }
+
+  // this * numerator / denominator, rounded toward zero. The product may leave the range as long as the result does
+  // not; numerator * denominator must fit in 63 bits.
+  [[nodiscard]] constexpr Fixed mulDiv(int64_t numerator, int64_t denominator) const noexcept
+  {
+    return fromRaw(raw_ / denominator * numerator + raw_ % denominator * numerator / denominator);
+  }
+
+  friend constexpr bool operator==(Fixed a, Fixed b) noexcept
+  {
+    return a.raw_ == b.raw_;
+  }
+
+  friend constexpr bool operator!=(Fixed a, Fixed b) noexcept
+  {
+    return a.raw_ != b.raw_;
+  }
+
+  friend constexpr bool operator<(Fixed a, Fixed b) noexcept
+  {
+    return a.raw_ < b.raw_;
+  }
+
+  friend constexpr bool operator<=(Fixed a, Fixed b) noexcept
+  {
+    return a.raw_ <= b.raw_;
+  }
+
+  friend constexpr bool operator>(Fixed a, Fixed b) noexcept
+  {
+    return a.raw_ > b.raw_;
+  }
+
+  friend constexpr bool operator>=(Fixed a, Fixed b) noexcept
+  {
+    return a.raw_ >= b.raw_;
+  }
+
+private:
+  // (a * b) >> 32 with a 128-bit product. Without 128-bit integers (32-bit targets) the product is assembled from
+  // 32-bit halves, which gives the same bits.
+  static constexpr int64_t multiply(int64_t a, int64_t b) noexcept
+  {
+#ifdef __SIZEOF_INT128__
+    __extension__ typedef __int128 Wide;
+    return static_cast<int64_t>((static_cast<Wide>(a) * b) >> kFractionBits);
+#else
+    int64_t a_high = a >> kFractionBits;
+    int64_t b_high = b >> kFractionBits;
+    uint64_t a_low = static_cast<uint64_t>(a) & 0xffffffff;
+    uint64_t b_low = static_cast<uint64_t>(b) & 0xffffffff;
+    uint64_t result = (static_cast<uint64_t>(a_high * b_high) << kFractionBits) +
+                      static_cast<uint64_t>(a_high * static_cast<int64_t>(b_low)) +
+                      static_cast<uint64_t>(static_cast<int64_t>(a_low) * b_high) + ((a_low * b_low) >> kFractionBits);
+    return static_cast<int64_t>(result);
+#endif
+  }
+
+  int64_t raw_ = 0;
+};
+
+// The operations BasicWheelSmoother needs beyond + - * and comparisons, for each number type it is instantiated
+// with.
+template <typename Number>
+struct NumericPolicy;
+
+// Durations come in as whole microseconds and per second quantities are scaled to per tick ones through the policy,
+// so the Fixed one can keep every step in integers.
+template <>
+struct NumericPolicy<double>
+{
+  // Whether catching up on missed ticks may use the closed form, which needs log() and pow().
+  static constexpr bool kClosedForm = true;
+
+  // `value` per second times one tick of `tick_microseconds`.
+  static double perTick(double value, int tick_microseconds) noexcept
+  {
+    return value * (tick_microseconds / 1.e6);
+  }
+
+  // `value` per second squared times one tick squared.
+  static double perTickSquared(double value, int tick_microseconds) noexcept
+  {
+    return value * (tick_microseconds / 1.e6) * (tick_microseconds / 1.e6);
+  }
+
+  static double ticksPerSecond(int tick_microseconds) noexcept
+  {
+    return 1.0 / (tick_microseconds / 1.e6);
+  }
+
+  // e^(-rate * tick), what a quantity decaying at `rate` per second keeps over one tick.
+  static double decayPerTick(double rate, int tick_microseconds) noexcept
+  {
+    return std::exp(-rate * (tick_microseconds / 1.e6));
+  }
+
+  // part / whole, for 0 <= part < whole.
+  static double fraction(std::chrono::microseconds part, std::chrono::microseconds whole) noexcept
+  {
+    return std::chrono::duration<double>(part).count() / std::chrono::duration<double>(whole).count();
+  }
+
+  // `factor` * `count` per `duration`, per second.
+  static double rate(double factor, double count, std::chrono::microseconds duration) noexcept
+  {
+    return factor * count / std::chrono::duration<double>(duration).count();
+  }
+
+  static double fromDouble(double value) noexcept
+  {
+    return value;
+  }
+
+  static double toDouble(double value) noexcept
+  {
+    return value;
+  }
+
+  static int round(double value) noexcept
+  {
+    return std::round(value);
+  }
+};
+
+// Everything here is integer arithmetic on the options, which convert from double exactly, so a Fixed smoother's
+// output depends on nothing but its options and input.
+template <>
+struct NumericPolicy<Fixed>
+{
+  // Transcendental functions are not bit exact across libms, so missed ticks are stepped one by one.
+  static constexpr bool kClosedForm = false;
+
+  static Fixed perTick(Fixed value, int tick_microseconds) noexcept
+  {
+    return value.mulDiv(tick_microseconds, 1'000'000);
+  }
+
+  // Scaled one tick at a time, so that a small result keeps its precision.
+  static Fixed perTickSquared(Fixed value, int tick_microseconds) noexcept
+  {
+    return perTick(perTick(value, tick_microseconds), tick_microseconds);
+  }
+
+  static Fixed ticksPerSecond(int tick_microseconds) noexcept
+  {
+    return Fixed{ 1'000'000 }.mulDiv(1, tick_microseconds);
+  }
+
+  // e^-x from its Taylor series once x is halved below 1/8, where eight terms leave less than a bit of 2^-32 out,
+  // then squared back.
+  static Fixed decayPerTick(Fixed rate, int tick_microseconds) noexcept
+  {
+    Fixed x = perTick(rate, tick_microseconds);
+    int halvings = 0;
+    while (x > Fixed::fromRaw(Fixed::kOne / 8))
+    {
+      x = Fixed::fromRaw(x.raw() / 2);
+      ++halvings;
+    }
+
+    Fixed term = 1;
+    Fixed sum = 1;
+    for (int n = 1; n <= 8; ++n)
+    {
+      term = (-term * x).mulDiv(1, n);
+      sum += term;
+    }
+
+    for (; halvings > 0; --halvings)
+    {
+      sum *= sum;
+    }
+    return sum;
+  }
+
+  static Fixed fraction(std::chrono::microseconds part, std::chrono::microseconds whole) noexcept
+  {
+    return Fixed::fromRaw(Fixed{ part.count() }.raw() / whole.count());
+  }
+
+  static Fixed rate(Fixed factor, Fixed count, std::chrono::microseconds duration) noexcept
+  {
+    return (factor * count).mulDiv(1'000'000, duration.count());
+  }
+
+  static Fixed fromDouble(double value) noexcept
+  {
+    return Fixed::fromDouble(value);
+  }
+
+  static double toDouble(Fixed value) noexcept
+  {
+    return value.toDouble();
+  }
+
+  static int round(Fixed value) noexcept
+  {
+    return value.round();
+  }
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "output_queue.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+OutputQueue::OutputQueue(OutputSink& sink) : sink_{ sink }, slots_(kMaxFrames)
+{
+  // Merging only adds relative codes the frame does not have yet.
+  for (auto& frame : slots_)
+  {
+    frame.reserve(kMaxFrameEvents + REL_CNT);
+  }
+}
+
+bool OutputQueue::write(const struct input_event* events, size_t count)
+{
+  if (size_ != 0)
+    return push(events, count);
+
+
+  size_t written;
+  switch (sink_.write(events, count, written))
+  {
+    case WriteStatus::kSuccess:
+      return true;
+
+    case WriteStatus::kAgain:
+      ++stalls_;
+      stall_start_ = std::chrono::steady_clock::now();
+      stall_merged_frames_ = merged_frames_;
+      stall_dropped_frames_ = dropped_frames_;
+      push(events, count);  // into an empty queue
+      head_written_ = written;
+      return true;
+
+    case WriteStatus::kFailed:
+    default:
+      return false;
+  }
+}
+
+bool OutputQueue::flush()
+{
+  if (size_ == 0)
+    return true;
+
+  while (size_ != 0)
+  {
+    auto& frame = slot(0);
+
+    size_t written;
+    auto status = sink_.write(frame.data() + head_written_, frame.size() - head_written_, written);
+    if (status == WriteStatus::kFailed)
+      return false;
+
+    if (status == WriteStatus::kAgain)
+    {
+      head_written_ += written;
+      return true;
+    }
+
+    head_ = (head_ + 1) % kMaxFrames;
+    --size_;
+    head_written_ = 0;
+  }
+
+  auto stall = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - stall_start_);
+  SPDLOG_WARN("Output stalled for {}ms, {} frames merged, {} dropped", stall.count(),
+              merged_frames_ - stall_merged_frames_, dropped_frames_ - stall_dropped_frames_);
+  return true;
+}
+
+bool OutputQueue::relativeOnly(const std::vector<struct input_event>& frame) noexcept
+{
+  return relativeOnly(frame.data(), frame.size());
+}
+
+bool OutputQueue::relativeOnly(const struct input_event* events, size_t count) noexcept
+{
+  if (count == 0 || events[count - 1].type != EV_SYN || events[count - 1].code != SYN_REPORT)
+    return false;
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (events[i].type != EV_REL && events[i].type != EV_SYN)
+      return false;
+  }
+  return true;
+}
+
+bool OutputQueue::hasKeys(const struct input_event* events, size_t count) noexcept
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (events[i].type == EV_KEY)
+      return true;
+  }
+  return false;
+}
+
+bool OutputQueue::push(const struct input_event* events, size_t count)
+{
+  // A partly written frame can't change any more.
+  if (size_ > (head_written_ ? 1u : 0u) && relativeOnly(events, count) && relativeOnly(slot(size_ - 1)))
+  {
+    merge(slot(size_ - 1), events, count);
+    ++merged_frames_;
+    return true;
+  }
+
+  if (size_ == kMaxFrames)
+  {
+    size_t victim = size_;
+    for (size_t i = head_written_ ? 1 : 0; i < size_; ++i)
+    {
+      if (!hasKeys(slot(i).data(), slot(i).size()))
+      {
+        victim = i;
+        break;
+      }
+    }
+
+    if (victim < size_)
+    {
+      // Close the gap by shifting the older frames up by one.
+      for (size_t i = victim; i > 0; --i)
+      {
+        slot(i).swap(slot(i - 1));
+      }
+      head_ = (head_ + 1) % kMaxFrames;
+      --size_;
+      if (victim == 0)
+      {
+        head_written_ = 0;
+      }
+      ++dropped_frames_;
+    }
+    else if (hasKeys(events, count))
+    {
+      // Every waiting frame presses or releases a button. Motion can still be given up, but losing a key would
+      // leave a button stuck, so the loop waits for the sink instead.
+      SPDLOG_WARN("Output stalled with {} button frames waiting, waiting for the device", size_);
+      if (!waitForRoom())
+        return false;
+    }
+    else
+    {
+      ++dropped_frames_;
+      return true;
+    }
+  }
+
+  auto& frame = slot(size_);
+  frame.assign(events, events + count);
+  ++size_;
+  return true;
+}
+
+bool OutputQueue::waitForRoom()
+{
+  if (sink_.fd() < 0)
+    return false;
+
+  while (size_ == kMaxFrames)
+  {
+    struct pollfd pfd{ sink_.fd(), POLLOUT, 0 };
+    if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+    {
+      SPDLOG_ERROR("poll error: {}", strerror(errno));
+      return false;
+    }
+
+    if (!flush())
+      return false;
+  }
+  return true;
+}
+
+void OutputQueue::merge(std::vector<struct input_event>& frame, const struct input_event* events, size_t count)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    const auto& ev = events[i];
+    if (ev.type != EV_REL)
+      continue;
+
+    bool found = false;
+    for (auto& queued : frame)
+    {
+      if (queued.type == EV_REL && queued.code == ev.code)
+      {
+        queued.value += ev.value;
+        found = true;
+        break;
+      }
+    }
+
+    if (!found)
+    {
+      // Before the closing SYN_REPORT.
+      frame.insert(frame.end() - 1, ev);
+    }
+  }
+
+  frame.back().time = events[count - 1].time;
+}
+
+}  // namespace smooth_scroll
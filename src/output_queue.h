@@ -0,0 +1,102 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "io_backend.h"
+
+namespace smooth_scroll
+{
+
+// Sits in front of an OutputSink and keeps frames the sink could not take yet, so a stalled consumer delays output
+// instead of failing it. While frames are waiting, a new frame of relative motion and wheel deltas is merged into
+// the last waiting frame if that holds only relative events too. The queue holds at most kMaxFrames; beyond that
+// the oldest frame without key events is dropped, or the new one if every waiting frame has keys. A key event is
+// never dropped, since a lost button press or release leaves the button stuck: a queue that can only take one by
+// dropping another blocks until the sink takes the oldest frame. Every write is a single frame.
+class OutputQueue
+{
+public:
+  static constexpr size_t kMaxFrames = 64;
+
+  explicit OutputQueue(OutputSink& sink);
+
+  OutputQueue(const OutputQueue&) = delete;
+  OutputQueue& operator=(const OutputQueue&) = delete;
+
+  // Writes a frame, or queues it behind the frames still waiting. If the frame has key events and every waiting
+  // frame has them too, blocks until the sink makes room. Returns false if the sink failed.
+  bool write(const struct input_event* events, size_t count);
+
+  // Writes waiting frames until none are left or the sink is full again. Returns false if the sink failed.
+  bool flush();
+
+  [[nodiscard]] bool empty() const noexcept
+  {
+    return size_ == 0;
+  }
+
+  // The fd to wait on for writability while frames are waiting.
+  [[nodiscard]] int fd() const noexcept
+  {
+    return sink_.fd();
+  }
+
+  // How many times the sink filled up.
+  [[nodiscard]] uint64_t stalls() const noexcept
+  {
+    return stalls_;
+  }
+
+  [[nodiscard]] uint64_t merged_frames() const noexcept
+  {
+    return merged_frames_;
+  }
+
+  [[nodiscard]] uint64_t dropped_frames() const noexcept
+  {
+    return dropped_frames_;
+  }
+
+private:
+  // Whether a complete frame holds nothing but relative events.
+  static bool relativeOnly(const std::vector<struct input_event>& frame) noexcept;
+
+  static bool relativeOnly(const struct input_event* events, size_t count) noexcept;
+
+  static bool hasKeys(const struct input_event* events, size_t count) noexcept;
+
+  // Returns false if the sink failed while the queue waited for room.
+  bool push(const struct input_event* events, size_t count);
+
+  // Waits for the sink to take at least one frame of a full queue. Returns false if the sink failed.
+  bool waitForRoom();
+
+  void merge(std::vector<struct input_event>& frame, const struct input_event* events, size_t count);
+
+  std::vector<struct input_event>& slot(size_t index) noexcept
+  {
+    return slots_[(head_ + index) % kMaxFrames];
+  }
+
+  OutputSink& sink_;
+
+  // Ring of waiting frames, each reserved for the largest frame up front so queueing never allocates.
+  std::vector<std::vector<struct input_event>> slots_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  size_t head_written_ = 0;  // events of the first frame already written
+
+  std::chrono::steady_clock::time_point stall_start_;
+  uint64_t stalls_ = 0;
+  uint64_t merged_frames_ = 0;
+  uint64_t dropped_frames_ = 0;
+  uint64_t stall_merged_frames_ = 0;
+  uint64_t stall_dropped_frames_ = 0;
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "pipe_backend.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace smooth_scroll
+{
+
+PipeInputSource::PipeInputSource(int fd) noexcept : fd_(fd), reader_(fd)
+{
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+}
+
+PipeInputSource::~PipeInputSource()
+{
+  close(fd_);
+}
+
+WriteStatus MemoryOutputSink::write(const struct input_event* events, size_t count, size_t& written) noexcept
+{
+  written = count;
+  if (count == 0)
+    return WriteStatus::kSuccess;
+
+  const struct input_event& syn = events[count - 1];
+  std::chrono::microseconds frame_time = std::chrono::seconds{ syn.time.tv_sec } +
+                                         std::chrono::microseconds{ syn.time.tv_usec };
+  std::chrono::microseconds latency = std::max(clock_.now() - frame_time, std::chrono::microseconds{ 0 });
+
+  ++frames_;
+  events_ += count;
+  total_latency_ += latency;
+  max_latency_ = std::max(max_latency_, latency);
+
+  bool multi_frame = false;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (events[i].type == EV_REL && (events[i].code == REL_WHEEL_HI_RES || events[i].code == REL_HWHEEL_HI_RES))
+    {
+      ++wheel_events_;
+      wheel_distance_ += std::abs(events[i].value);
+    }
+    else if (events[i].type == EV_SYN && events[i].code == SYN_REPORT && i + 1 < count)
+    {
+      multi_frame = true;
+    }
+  }
+  multi_frame_writes_ += multi_frame;
+
+  return WriteStatus::kSuccess;
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "clock.h"
+#include "frame_reader.h"
+#include "io_backend.h"
+
+namespace smooth_scroll
+{
+
+// Reads raw input_event structs from a pipe or socket, so the event loop can be driven without real devices.
+// Takes ownership of the fd. End of file is reported as a lost device.
+class PipeInputSource : public InputSource
+{
+public:
+  explicit PipeInputSource(int fd) noexcept;
+
+  ~PipeInputSource() override;
+
+  PipeInputSource(const PipeInputSource&) = delete;
+  PipeInputSource& operator=(const PipeInputSource&) = delete;
+
+  [[nodiscard]] int fd() const noexcept override
+  {
+    return fd_;
+  }
+
+  ReadStatus next(struct input_event& ev) noexcept override
+  {
+    return reader_.nextEvent(ev);
+  }
+
+  ReadStatus nextFrame(Frame& frame) noexcept override
+  {
+    return reader_.next(frame);
+  }
+
+  [[nodiscard]] uint64_t syn_dropped() const noexcept override
+  {
+    return reader_.syn_dropped();
+  }
+
+private:
+  int fd_;
+  FrameReader reader_;
+};
+
+// Keeps counters of the frames written to it instead of forwarding them anywhere. Latency is measured from the
+// SYN_REPORT timestamp of each frame to the moment it is written, as `clock` tells it.
+class MemoryOutputSink : public OutputSink
+{
+public:
+  explicit MemoryOutputSink(const Clock& clock = SystemClock::instance()) noexcept : clock_{ clock }
+  {
+  }
+
+  [[nodiscard]] int fd() const noexcept override
+  {
+    return -1;
+  }
+
+  WriteStatus write(const struct input_event* events, size_t count, size_t& written) noexcept override;
+
+  [[nodiscard]] uint64_t frames() const noexcept
+  {
+    return frames_;
+  }
+
+  [[nodiscard]] uint64_t events() const noexcept
+  {
+    return events_;
+  }
+
+  [[nodiscard]] uint64_t wheel_events() const noexcept
+  {
+    return wheel_events_;
+  }
+
+  // Sum of the smoothed wheel values, in hi-res units.
+  [[nodiscard]] int64_t wheel_distance() const noexcept
+  {
+    return wheel_distance_;
+  }
+
+  // Writes that carried more than one frame, which the OutputSink contract rules out.
+  [[nodiscard]] uint64_t multi_frame_writes() const noexcept
+  {
+    return multi_frame_writes_;
+  }
+
+  [[nodiscard]] std::chrono::microseconds max_latency() const noexcept
+  {
+    return max_latency_;
+  }
+
+  [[nodiscard]] std::chrono::microseconds total_latency() const noexcept
+  {
+    return total_latency_;
+  }
+
+private:
+  const Clock& clock_;
+  uint64_t frames_ = 0;
+  uint64_t events_ = 0;
+  uint64_t wheel_events_ = 0;
+  int64_t wheel_distance_ = 0;
+  uint64_t multi_frame_writes_ = 0;
+  std::chrono::microseconds max_latency_{ 0 };
+  std::chrono::microseconds total_latency_{ 0 };
+};
+
+}  // namespace smooth_scroll
@@ -0,0 +1,17 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "probes.h"
+
+#ifdef SMOOTH_SCROLL_USDT
+
+// In the .probes section, where tracers look for the semaphores the probe notes point to.
+#define SMOOTH_SCROLL_DEFINE_SEMAPHORE(name) \
+  volatile unsigned short SMOOTH_SCROLL_PROBE_SEMAPHORE(name) __attribute__((section(".probes"))) = 0;
+extern "C"
+{
+  SMOOTH_SCROLL_PROBE_NAMES(SMOOTH_SCROLL_DEFINE_SEMAPHORE)
+}
+#undef SMOOTH_SCROLL_DEFINE_SEMAPHORE
+
+#endif
@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+// USDT probes under the `smooth_scroll` provider, for bpftrace and perf on a running daemon. Every probe has an SDT
+// semaphore that a tracer increments while it is attached, so an unattached probe costs a test of that global and a
+// nop, and its arguments are not even evaluated. Without SMOOTH_SCROLL_USDT (no sys/sdt.h at build time) the macros
+// expand to nothing. See docs/usdt_probes.md.
+
+#ifdef SMOOTH_SCROLL_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+// Every probe name, for declaring and defining their semaphores. A probe missing here doesn't link.
+#define SMOOTH_SCROLL_PROBE_NAMES(X) \
+  X(wheel_event)                     \
+  X(tick)                            \
+  X(report)                          \
+  X(stop)                            \
+  X(brake_signal)                    \
+  X(passthrough)                     \
+  X(write_events)
+
+#define SMOOTH_SCROLL_PROBE_SEMAPHORE(name) smooth_scroll_##name##_semaphore
+
+// sys/sdt.h refers to the semaphores by these unmangled names. They are defined in probes.cpp.
+#define SMOOTH_SCROLL_DECLARE_SEMAPHORE(name) extern volatile unsigned short SMOOTH_SCROLL_PROBE_SEMAPHORE(name);
+extern "C"
+{
+  SMOOTH_SCROLL_PROBE_NAMES(SMOOTH_SCROLL_DECLARE_SEMAPHORE)
+}
+#undef SMOOTH_SCROLL_DECLARE_SEMAPHORE
+
+namespace smooth_scroll::detail
+{
+
+// Set on threads whose smoothers must not fire probes, such as the shadow smoother's, so that tracing scripts only
+// ever see the live one. Only read while a tracer is attached.
+inline thread_local bool probes_disabled = false;
+
+}  // namespace smooth_scroll::detail
+
+// True while a tracer is attached to the probe, on threads that fire probes.
+#define SMOOTH_SCROLL_PROBE_ENABLED(name) \
+  (__builtin_expect(SMOOTH_SCROLL_PROBE_SEMAPHORE(name), 0) && !::smooth_scroll::detail::probes_disabled)
+
+#define SMOOTH_SCROLL_PROBE_IF_ENABLED(name, probe) \
+  do                                                \
+  {                                                 \
+    if (SMOOTH_SCROLL_PROBE_ENABLED(name))          \
+    {                                               \
+      probe;                                        \
+    }                                               \
+  } while (0)
+
+#define SMOOTH_SCROLL_PROBE(name) SMOOTH_SCROLL_PROBE_IF_ENABLED(name, DTRACE_PROBE(smooth_scroll, name))
+#define SMOOTH_SCROLL_PROBE1(name, a) SMOOTH_SCROLL_PROBE_IF_ENABLED(name, DTRACE_PROBE1(smooth_scroll, name, a))
+#define SMOOTH_SCROLL_PROBE2(name, a, b) SMOOTH_SCROLL_PROBE_IF_ENABLED(name, DTRACE_PROBE2(smooth_scroll, name, a, b))
+#define SMOOTH_SCROLL_PROBE3(name, a, b, c) \
+  SMOOTH_SCROLL_PROBE_IF_ENABLED(name, DTRACE_PROBE3(smooth_scroll, name, a, b, c))
+
+#else
+
+#define SMOOTH_SCROLL_PROBE(name) \
+  do                              \
+  {                               \
+  } while (0)
+#define SMOOTH_SCROLL_PROBE1(name, a) SMOOTH_SCROLL_PROBE(name)
+#define SMOOTH_SCROLL_PROBE2(name, a, b) SMOOTH_SCROLL_PROBE(name)
+#define SMOOTH_SCROLL_PROBE3(name, a, b, c) SMOOTH_SCROLL_PROBE(name)
+
+#endif
+
+namespace smooth_scroll
+{
+
+// First argument of the `stop` probe, and why a session in the session journal ended.
+enum class ProbeStopReason : int
+{
+  kExternal,  // WheelSmoother::stop() without a more specific reason: a brake signal or a library caller
+  kDamping,
+  kReverseScroll,
+  kMouseMovement,
+  kClick,        // a button other than free spin and drag view
+  kKeyboard,     // a braking or passthrough key
+  kPassthrough,  // passthrough forced over IPC
+  kAxisChange,   // a notch on the other axis
+  kDragView,
+};
+
+constexpr int kNumStopReasons = static_cast<int>(ProbeStopReason::kDragView) + 1;
+
+// As ss-journal and the metrics file print it.
+inline const char* stopReasonName(int reason)
+{
+  switch (static_cast<ProbeStopReason>(reason))
+  {
+    case ProbeStopReason::kExternal:
+      return "external";
+    case ProbeStopReason::kDamping:
+      return "damping";
+    case ProbeStopReason::kReverseScroll:
+      return "reverse_scroll";
+    case ProbeStopReason::kMouseMovement:
+      return "mouse_movement";
+    case ProbeStopReason::kClick:
+      return "click";
+    case ProbeStopReason::kKeyboard:
+      return "keyboard";
+    case ProbeStopReason::kPassthrough:
+      return "passthrough";
+    case ProbeStopReason::kAxisChange:
+      return "axis_change";
+    case ProbeStopReason::kDragView:
+      return "drag_view";
+  }
+  return "unknown";
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "realtime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+constexpr size_t kPrefaultStackBytes = 256 * 1024;
+
+// Parses a sysfs CPU list such as "0-7,16" and returns the highest CPU in it, or -1.
+int highestCpuInList(const std::string& list)
+{
+  int highest = -1;
+  size_t pos = 0;
+  while (pos < list.size())
+  {
+    size_t end = list.find(',', pos);
+    if (end == std::string::npos)
+    {
+      end = list.size();
+    }
+
+    std::string range = list.substr(pos, end - pos);
+    size_t dash = range.find('-');
+    try
+    {
+      int cpu = std::stoi(dash == std::string::npos ? range : range.substr(dash + 1));
+      highest = std::max(highest, cpu);
+    }
+    catch (const std::exception&)
+    {
+    }
+
+    pos = end + 1;
+  }
+  return highest;
+}
+
+void prefaultStack()
+{
+  volatile char stack[kPrefaultStackBytes];
+  for (size_t i = 0; i < sizeof(stack); i += 4096)
+  {
+    stack[i] = 0;
+  }
+}
+
+}  // namespace
+
+int findFastestCpu()
+{
+  // Intel hybrid parts list their performance cores here.
+  std::ifstream core_cpus("/sys/devices/cpu_core/cpus");
+  std::string list;
+  if (core_cpus && std::getline(core_cpus, list))
+  {
+    int cpu = highestCpuInList(list);
+    if (cpu >= 0)
+      return cpu;
+  }
+
+  int fastest = -1;
+  long fastest_freq = 0;
+  long num_cpus = std::min<long>(sysconf(_SC_NPROCESSORS_CONF), CPU_SETSIZE);
+  for (int cpu = 0; cpu < num_cpus; ++cpu)
+  {
+    std::ifstream freq_file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq");
+    long freq;
+    if (!(freq_file >> freq))
+      continue;
+
+    if (freq >= fastest_freq)
+    {
+      fastest_freq = freq;
+      fastest = cpu;
+    }
+  }
+  return fastest;
+}
+
+void applyRealtime(const RealtimeOptions& options)
+{
+  if (options.lock_memory)
+  {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+    {
+      prefaultStack();
+      SPDLOG_INFO("Realtime: memory locked");
+    }
+    else
+    {
+      SPDLOG_WARN("Realtime: mlockall failed: {}", strerror(errno));
+    }
+  }
+
+  int cpu = options.auto_cpu ? findFastestCpu() : options.cpu;
+  if (options.auto_cpu && cpu < 0)
+  {
+    SPDLOG_WARN("Realtime: can't tell which core is fastest, not pinning");
+  }
+
+  if (cpu >= 0)
+  {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+    {
+      SPDLOG_INFO("Realtime: pinned to CPU {}", cpu);
+    }
+    else
+    {
+      SPDLOG_WARN("Realtime: pinning to CPU {} failed: {}", cpu, strerror(errno));
+    }
+  }
+
+  if (options.priority > 0)
+  {
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = options.priority;
+    if (sched_setscheduler(0, SCHED_FIFO, &param) == 0)
+    {
+      SPDLOG_INFO("Realtime: SCHED_FIFO priority {}", options.priority);
+    }
+    else
+    {
+      SPDLOG_WARN("Realtime: SCHED_FIFO priority {} failed: {}", options.priority, strerror(errno));
+    }
+  }
+}
+
+TimerSlack::TimerSlack(unsigned long scrolling_ns) noexcept : scrolling_ns_(scrolling_ns)
+{
+  if (scrolling_ns_)
+  {
+    int idle_ns = prctl(PR_GET_TIMERSLACK);
+    if (idle_ns < 0)
+    {
+      SPDLOG_WARN("Realtime: can't read timer slack, leaving it alone");
+      scrolling_ns_ = 0;
+      return;
+    }
+
+    idle_ns_ = idle_ns;
+    SPDLOG_INFO("Realtime: timer slack {}ns while scrolling, {}ns at idle", scrolling_ns_, idle_ns_);
+  }
+}
+
+void TimerSlack::setScrolling(bool scrolling) noexcept
+{
+  if (scrolling == scrolling_ || !scrolling_ns_)
+    return;
+
+  scrolling_ = scrolling;
+  prctl(PR_SET_TIMERSLACK, scrolling ? scrolling_ns_ : idle_ns_);
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+namespace smooth_scroll
+{
+
+// Opt-in measures that keep the input thread on time when the machine is busy. Each one is attempted separately and
+// its outcome logged, so a missing privilege only costs that one measure.
+struct RealtimeOptions
+{
+  int priority = 0;        // SCHED_FIFO priority 1-99, 0 keeps SCHED_OTHER
+  bool lock_memory = false;  // mlockall and prefault the stack
+  int cpu = -1;            // CPU to pin the input thread to, -1 for none
+  bool auto_cpu = false;   // pick the fastest core instead of `cpu`
+};
+
+// Applies `options` to the calling thread and the process.
+void applyRealtime(const RealtimeOptions& options);
+
+// Finds the core to pin to: one of the performance cores on hybrid CPUs, otherwise one with the highest maximum
+// frequency. Prefers the highest numbered of equal cores, as CPU 0 usually takes the most interrupts. Returns -1
+// if the topology can't be read.
+int findFastestCpu();
+
+// Switches the calling thread's timer slack between a minimal value while scrolling and its original value at idle,
+// so select() timeouts fire on time during a scroll without costing power the rest of the time.
+class TimerSlack
+{
+public:
+  // `scrolling_ns` of 0 disables switching.
+  explicit TimerSlack(unsigned long scrolling_ns) noexcept;
+
+  TimerSlack(const TimerSlack&) = delete;
+  TimerSlack& operator=(const TimerSlack&) = delete;
+
+  void setScrolling(bool scrolling) noexcept;
+
+private:
+  unsigned long scrolling_ns_;
+  unsigned long idle_ns_ = 0;
+  bool scrolling_ = false;
+};
+
+}  // namespace smooth_scroll
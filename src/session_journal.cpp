@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "session_journal.h"
+
+#include "state_dir.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+constexpr size_t kJournalSize = sizeof(JournalHeader) + sizeof(JournalRecord) * SessionJournal::kCapacity;
+
+}  // namespace
+
+SessionJournal::~SessionJournal()
+{
+  close();
+}
+
+bool SessionJournal::open(const std::string& path)
+{
+  makeDirectories(path);
+
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd_ < 0)
+  {
+    SPDLOG_WARN("Failed to open session journal {}: {}", path, strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  bool reuse = fstat(fd_, &st) == 0 && st.st_size == static_cast<off_t>(kJournalSize);
+
+  if (ftruncate(fd_, kJournalSize) < 0)
+  {
+    SPDLOG_WARN("Failed to resize session journal {}: {}", path, strerror(errno));
+    close();
+    return false;
+  }
+
+  // Faulted in now so that appends never wait for a page.
+  void* addr = mmap(nullptr, kJournalSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+  if (addr == MAP_FAILED)
+  {
+    SPDLOG_WARN("Failed to map session journal {}: {}", path, strerror(errno));
+    close();
+    return false;
+  }
+
+  header_ = static_cast<JournalHeader*>(addr);
+  records_ = reinterpret_cast<JournalRecord*>(header_ + 1);
+
+  reuse = reuse && header_->magic_version == kJournalMagicVersion && header_->record_size == sizeof(JournalRecord) &&
+          header_->capacity == kCapacity;
+  if (reuse)
+  {
+    next_ = header_->next.load(std::memory_order_relaxed);
+  }
+  else
+  {
+    std::memset(addr, 0, kJournalSize);
+    header_->record_size = sizeof(JournalRecord);
+    header_->capacity = kCapacity;
+    header_->next.store(0, std::memory_order_relaxed);
+    header_->magic_version = kJournalMagicVersion;
+    next_ = 0;
+  }
+
+  SPDLOG_INFO("Session journal {} ({} sessions recorded)", path, next_);
+  return true;
+}
+
+void SessionJournal::close() noexcept
+{
+  if (header_)
+  {
+    munmap(header_, kJournalSize);
+    header_ = nullptr;
+    records_ = nullptr;
+  }
+
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+void SessionJournal::append(const ScrollSession& session, std::chrono::microseconds latency) noexcept
+{
+  if (!header_)
+    return;
+
+  JournalRecord record{};
+  record.start_us = session.start_time.count();
+  record.end_us = session.end_time.count();
+  record.latency_us = latency.count();
+  record.peak_speed = session.peak_speed;
+  record.distance = session.distance;
+  record.notches = session.notches;
+  record.stop_reason = static_cast<uint8_t>(session.stop_reason);
+  record.horizontal = session.horizontal;
+
+  std::memcpy(&records_[next_ % kCapacity], &record, sizeof(record));
+  header_->next.store(++next_, std::memory_order_release);
+}
+
+}  // namespace smooth_scroll
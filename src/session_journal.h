@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "wheel_smoother.h"
+
+namespace smooth_scroll
+{
+
+// One scroll session in the journal file.
+struct JournalRecord
+{
+  int64_t start_us;  // first notch, microseconds since the epoch
+  int64_t end_us;    // last scroll output
+  // Longest delay from a mouse event to the scroll output it caused, as seen by the event loop.
+  int64_t latency_us;
+  double peak_speed;  // hi-res units per second
+  int32_t distance;   // hi-res units
+  int32_t notches;
+  uint8_t stop_reason;  // ProbeStopReason
+  uint8_t horizontal;
+  uint8_t reserved[6];
+};
+
+static_assert(sizeof(JournalRecord) == 48, "journal record size must be exactly 48 bytes");
+
+// The start of the journal file, followed by `capacity` records. Record `n` is at index n % capacity, so once the
+// journal is full each session overwrites the oldest one. `next` counts every record ever written and is stored
+// after the record itself, so readers take the records below it.
+struct alignas(64) JournalHeader
+{
+  uint32_t magic_version;
+  uint32_t record_size;
+  uint32_t capacity;
+  uint32_t reserved;
+  std::atomic<uint64_t> next;
+};
+
+static_assert(sizeof(JournalHeader) == 64, "journal header size must be exactly 64 bytes");
+
+constexpr uint32_t kJournalMagicVersion = 0x534a0001;
+
+// Keeps a record of every scroll session in a memory-mapped ring file, for ss-journal to summarise. The file is
+// mapped and faulted in when it is opened, so an append is one memcpy into the mapping plus a store of the count;
+// the kernel writes the pages back on its own schedule and nothing is ever synced from the event loop. A journal
+// left by an earlier run is continued if its layout matches, and started over otherwise.
+class SessionJournal
+{
+public:
+  static constexpr uint32_t kCapacity = 4096;
+
+  SessionJournal() = default;
+
+  ~SessionJournal();
+
+  SessionJournal(const SessionJournal&) = delete;
+  SessionJournal& operator=(const SessionJournal&) = delete;
+
+  bool open(const std::string& path);
+
+  void append(const ScrollSession& session, std::chrono::microseconds latency) noexcept;
+
+private:
+  void close() noexcept;
+
+  int fd_ = -1;
+  JournalHeader* header_ = nullptr;
+  JournalRecord* records_ = nullptr;
+  uint64_t next_ = 0;
+};
+
+}  // namespace smooth_scroll
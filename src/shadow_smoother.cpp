@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "shadow_smoother.h"
+
+#include "binary_log.h"
+#include "probes.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+// Ticks run only this far behind the clock while the ring is empty, so a frame still on its way through the
+// event loop arrives before the ticks that should follow it.
+constexpr auto kTickLag = std::chrono::milliseconds{ 100 };
+
+constexpr auto kPollInterval = std::chrono::milliseconds{ 20 };
+
+std::chrono::microseconds eventTime(const struct input_event& ev)
+{
+  return std::chrono::seconds{ ev.time.tv_sec } + std::chrono::microseconds{ ev.time.tv_usec };
+}
+
+}  // namespace
+
+ShadowSmoother::Side::Side(const EventRouter::Options& router_options, const WheelSmoother::Options& options)
+  : router{ router_options, options }
+{
+}
+
+void ShadowSmoother::Side::tickUntil(std::chrono::microseconds time)
+{
+  while (auto next_tick_time = router.next_tick_time())
+  {
+    if (*next_tick_time > time)
+      break;
+
+    auto start = std::chrono::steady_clock::now();
+    router.tick(*next_tick_time);
+    tick_time += std::chrono::steady_clock::now() - start;
+    ++ticks;
+
+    collect();
+  }
+}
+
+void ShadowSmoother::Side::collect()
+{
+  for (const auto* output : { &router.output(), &router.wheel_output() })
+  {
+    for (const auto& ev : *output)
+    {
+      if (ev.type == EV_REL && (ev.code == REL_WHEEL_HI_RES || ev.code == REL_HWHEEL_HI_RES))
+      {
+        distance += std::abs(ev.value);
+        last_output_time = eventTime(ev);
+      }
+    }
+  }
+  router.clearOutput();
+}
+
+ShadowSmoother::ShadowSmoother(const EventRouter::Options& router_options, const WheelSmoother::Options& live_options,
+                               const WheelSmoother::Options& shadow_options, std::string log_path, Clock& clock)
+  : clock_{ clock }
+  , live_{ router_options, live_options }
+  , shadow_{ router_options, shadow_options }
+  , log_path_{ std::move(log_path) }
+{
+}
+
+ShadowSmoother::~ShadowSmoother()
+{
+  stop();
+}
+
+void ShadowSmoother::start()
+{
+  if (running_.exchange(true))
+    return;
+
+  if (!log_path_.empty())
+  {
+    bool exists = access(log_path_.c_str(), F_OK) == 0;
+    log_file_.open(log_path_, std::ios::app);
+    if (!log_file_)
+    {
+      SPDLOG_WARN("Failed to open shadow log {}, logging gestures instead", log_path_);
+    }
+    else if (!exists)
+    {
+      log_file_ << "time_us,notches,live_distance,shadow_distance,live_stop_us,shadow_stop_us,live_tick_ns,"
+                   "shadow_tick_ns\n";
+    }
+  }
+
+  thread_ = std::thread(&ShadowSmoother::run, this);
+}
+
+void ShadowSmoother::stop()
+{
+  if (!running_.exchange(false))
+    return;
+
+  thread_.join();
+}
+
+void ShadowSmoother::push(const struct input_event* events, size_t count) noexcept
+{
+  size_t head = head_.load(std::memory_order_relaxed);
+  if (kCapacity - (head - tail_.load(std::memory_order_acquire)) < count)
+  {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  for (size_t i = 0; i < count; ++i)
+  {
+    events_[(head + i) & (kCapacity - 1)] = events[i];
+  }
+
+  head_.store(head + count, std::memory_order_release);
+}
+
+void ShadowSmoother::run()
+{
+  // The routers' debug messages would make this a second producer for the debug log, and their probes would count
+  // the shadow's ticks and stops with the live ones.
+  detail::log_events_disabled = true;
+#ifdef SMOOTH_SCROLL_USDT
+  detail::probes_disabled = true;
+#endif
+
+  while (running_.load(std::memory_order_relaxed))
+  {
+    drain();
+
+    auto now = clock_.now();
+    live_.tickUntil(now - kTickLag);
+    shadow_.tickUntil(now - kTickLag);
+    update();
+
+    std::this_thread::sleep_for(kPollInterval);
+  }
+
+  drain();
+}
+
+void ShadowSmoother::drain()
+{
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  size_t head = head_.load(std::memory_order_acquire);
+
+  for (; tail != head; ++tail)
+  {
+    handleEvent(events_[tail & (kCapacity - 1)]);
+    tail_.store(tail + 1, std::memory_order_release);
+  }
+
+  if (auto dropped = dropped_.exchange(0, std::memory_order_relaxed))
+  {
+    SPDLOG_WARN("Shadow ring full, {} frames dropped", dropped);
+  }
+}
+
+void ShadowSmoother::handleEvent(const struct input_event& ev)
+{
+  auto time = eventTime(ev);
+
+  // Between frames only: the routers act on a frame's wheel events at its SYN_REPORT.
+  if (!in_frame_)
+  {
+    live_.tickUntil(time);
+    shadow_.tickUntil(time);
+    update();
+    in_frame_ = true;
+  }
+
+  if (ev.type == EV_REL && (ev.code == REL_WHEEL || ev.code == REL_HWHEEL) && ev.value != 0)
+  {
+    if (!in_gesture_)
+    {
+      in_gesture_ = true;
+      notches_ = 0;
+      for (auto* side : { &live_, &shadow_ })
+      {
+        side->distance = 0;
+        side->last_output_time = time;
+        side->ticks = 0;
+        side->tick_time = std::chrono::nanoseconds{ 0 };
+      }
+    }
+
+    notches_ += std::abs(ev.value);
+    last_notch_time_ = time;
+  }
+
+  live_.router.handleMouseEvent(ev);
+  shadow_.router.handleMouseEvent(ev);
+
+  if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+  {
+    live_.collect();
+    shadow_.collect();
+    update();
+    in_frame_ = false;
+  }
+}
+
+void ShadowSmoother::update()
+{
+  if (!in_gesture_ || live_.router.next_tick_time() || shadow_.router.next_tick_time())
+    return;
+
+  in_gesture_ = false;
+
+  // Notches swallowed by braking on both sides.
+  if (live_.distance == 0 && shadow_.distance == 0)
+    return;
+
+  report();
+}
+
+void ShadowSmoother::report()
+{
+  auto stop_time = [this](const Side& side) {
+    return std::max(side.last_output_time - last_notch_time_, std::chrono::microseconds{ 0 }).count();
+  };
+  auto tick_cost = [](const Side& side) { return side.ticks ? side.tick_time.count() / side.ticks : int64_t{ 0 }; };
+
+  if (log_file_.is_open())
+  {
+    log_file_ << fmt::format("{},{},{},{},{},{},{},{}\n", last_notch_time_.count(), notches_, live_.distance,
+                             shadow_.distance, stop_time(live_), stop_time(shadow_), tick_cost(live_),
+                             tick_cost(shadow_));
+    log_file_.flush();
+    return;
+  }
+
+  SPDLOG_INFO("Shadow gesture: {} notches, distance {} live {} shadow ({:+.1f}%), stop after {}ms live {}ms shadow, "
+              "tick {}ns live {}ns shadow",
+              notches_, live_.distance, shadow_.distance,
+              live_.distance ? 100.0 * (shadow_.distance - live_.distance) / live_.distance : 0.0,
+              stop_time(live_) / 1000, stop_time(shadow_) / 1000, tick_cost(live_), tick_cost(shadow_));
+}
+
+}  // namespace smooth_scroll
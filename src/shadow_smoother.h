@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include <linux/input.h>
+
+#include "clock.h"
+#include "event_router.h"
+
+namespace smooth_scroll
+{
+
+// Tries alternate smoother options on live input without anyone feeling them. The event loop copies every mouse
+// frame into a single-producer single-consumer ring and goes on; a background thread replays the frames through two
+// EventRouters, one with the live options and one with the shadow options, running their ticks in event time, and
+// writes nothing to uinput. For every gesture it logs how far each one scrolled, how long each took to stop after the
+// last notch and what a tick cost each. When the ring is full frames are dropped and counted rather than blocking
+// the event loop. Keyboard braking and passthrough are not mirrored.
+class ShadowSmoother
+{
+public:
+  static constexpr size_t kCapacity = 4096;
+
+  // Gestures go to `log_path` as CSV lines if it is not empty, to the log otherwise. `clock` is the event loop's, so
+  // that ticks follow the same time as the input.
+  ShadowSmoother(const EventRouter::Options& router_options, const WheelSmoother::Options& live_options,
+                 const WheelSmoother::Options& shadow_options, std::string log_path,
+                 Clock& clock = SystemClock::instance());
+
+  ~ShadowSmoother();
+
+  ShadowSmoother(const ShadowSmoother&) = delete;
+  ShadowSmoother& operator=(const ShadowSmoother&) = delete;
+
+  void start();
+
+  void stop();
+
+  // Copies a complete frame into the ring, or drops all of it if it doesn't fit.
+  void push(const struct input_event* events, size_t count) noexcept;
+
+private:
+  static_assert((kCapacity & (kCapacity - 1)) == 0);
+
+  // One of the two routers and what it did in the current gesture.
+  struct Side
+  {
+    Side(const EventRouter::Options& router_options, const WheelSmoother::Options& options);
+
+    // Runs the ticks due at or before `time` and collects their output.
+    void tickUntil(std::chrono::microseconds time);
+
+    void collect();
+
+    EventRouter router;
+    int64_t distance = 0;
+    std::chrono::microseconds last_output_time{ 0 };
+    int64_t ticks = 0;
+    std::chrono::nanoseconds tick_time{ 0 };
+  };
+
+  void run();
+
+  void drain();
+
+  void handleEvent(const struct input_event& ev);
+
+  // Starts or ends a gesture as the routers start and stop scrolling.
+  void update();
+
+  void report();
+
+  Clock& clock_;
+  Side live_;
+  Side shadow_;
+  std::string log_path_;
+  std::ofstream log_file_;
+
+  bool in_frame_ = false;
+  bool in_gesture_ = false;
+  int notches_ = 0;
+  std::chrono::microseconds last_notch_time_{ 0 };
+
+  std::array<struct input_event, kCapacity> events_;
+  alignas(64) std::atomic<size_t> head_{ 0 };
+  alignas(64) std::atomic<size_t> tail_{ 0 };
+  std::atomic<uint64_t> dropped_{ 0 };
+  std::atomic_bool running_{ false };
+  std::thread thread_;
+};
+
+}  // namespace smooth_scroll
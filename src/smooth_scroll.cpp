@@ -1,23 +1,33 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2026 Wayne6530
 
+#include <algorithm>
 #include <atomic>
+#include <memory>
 #include <optional>
 #include <chrono>
 #include <string_view>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include <dirent.h>
 #include <libevdev-1.0/libevdev/libevdev.h>
-#include <linux/uinput.h>
 #include <signal.h>
 #include <spdlog/spdlog.h>
 #include <spdlog/fmt/ranges.h>
 #include <toml++/toml.hpp>
 
-#include "wheel_smoother.h"
+#include "binary_log.h"
+#include "clock.h"
+#include "device_calibrator.h"
+#include "device_scan.h"
+#include "evdev_backend.h"
+#include "event_loop.h"
 #include "ipc_server.h"
+#include "realtime.h"
+#include "metrics.h"
+#include "session_journal.h"
+#include "shadow_smoother.h"
 #include "version.h"
 
 using namespace std::string_view_literals;
@@ -41,90 +51,78 @@ std::atomic_bool kShutdown{ false };
 
 void signalHandler(int signal_num)
 {
-  if (signal_num == SIGINT)
+  if (signal_num == SIGINT || signal_num == SIGTERM)
   {
     kShutdown.store(true, std::memory_order_relaxed);
   }
 }
 
-std::string findDevice()
+// Where the daemon keeps what it learns about devices: the state directory systemd gives the service, or the user's
+// XDG state directory.
+std::string stateDirectory()
 {
-  std::vector<std::pair<std::string, int>> mouse_devices;
+  if (const char* dir = getenv("STATE_DIRECTORY"))
+    return dir;
+  if (const char* dir = getenv("XDG_STATE_HOME"))
+    return std::string(dir) + "/smooth-scroll";
+  if (const char* home = getenv("HOME"))
+    return std::string(home) + "/.local/state/smooth-scroll";
+  return "";
+}
 
-  DIR* dir = opendir("/dev/input");
-  if (!dir)
+DeviceScan::Device* findDevice(DeviceScan& scan, const LastDevice& last, Clock& clock)
+{
+  std::vector<DeviceScan::Device*> mouse_devices;
+  for (auto& device : scan.devices())
   {
-    SPDLOG_ERROR("Failed to open /dev/input directory");
-    return "";
+    if (device.is_mouse)
+    {
+      mouse_devices.push_back(&device);
+    }
   }
 
-  dirent* entry;
-  while ((entry = readdir(dir)) != nullptr)
+  if (mouse_devices.empty())
   {
-    std::string_view name = entry->d_name;
-    if (name.rfind("event", 0) == 0)
-    {
-      std::string path = "/dev/input/" + std::string(name);
-
-      int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
-      if (fd < 0)
-      {
-        SPDLOG_WARN("Failed to open device {}: {}", path, strerror(errno));
-        continue;
-      }
-
-      libevdev* dev = nullptr;
-      int rc = libevdev_new_from_fd(fd, &dev);
-      if (rc < 0)
-      {
-        SPDLOG_WARN("Failed to initialize libevdev for {}: {}", path, strerror(-rc));
-        close(fd);
-        continue;
-      }
-
-      bool is_mouse = libevdev_has_event_type(dev, EV_REL) && libevdev_has_event_code(dev, EV_REL, REL_X) &&
-                      libevdev_has_event_code(dev, EV_REL, REL_Y) && libevdev_has_event_code(dev, EV_REL, REL_WHEEL);
-
-      libevdev_free(dev);
+    SPDLOG_ERROR("No mouse devices found");
+    return nullptr;
+  }
 
-      if (is_mouse)
-      {
-        SPDLOG_DEBUG("Found mouse device: {}", path);
-        mouse_devices.emplace_back(path, fd);
-      }
-      else
-      {
-        SPDLOG_DEBUG("Device {} is not a mouse", path);
-        close(fd);
-      }
+  // Prefer the device used last time, and among several of the same model the one on the same port.
+  DeviceScan::Device* last_device = nullptr;
+  for (auto* device : mouse_devices)
+  {
+    if (!last.identity.empty() && device->identity == last.identity && (!last_device || device->phys == last.phys))
+    {
+      last_device = device;
     }
   }
-  closedir(dir);
 
-  if (mouse_devices.empty())
+  if (last_device)
   {
-    SPDLOG_ERROR("No mouse devices found");
-    return "";
+    SPDLOG_INFO("Use last device: {} ({})", last_device->path, last_device->identity);
+    return last_device;
+  }
+
+  if (mouse_devices.size() == 1)
+  {
+    SPDLOG_INFO("Use the only mouse device: {} ({})", mouse_devices[0]->path, mouse_devices[0]->identity);
+    return mouse_devices[0];
   }
 
   SPDLOG_INFO("Detecting active device...");
 
-  std::chrono::microseconds deadline = std::chrono::duration_cast<std::chrono::microseconds>(
-      (std::chrono::system_clock::now() + std::chrono::seconds{ 10 }).time_since_epoch());
+  std::chrono::microseconds deadline = clock.now() + std::chrono::seconds{ 10 };
   fd_set read_fds;
   while (!kShutdown.load(std::memory_order_relaxed))
   {
     FD_ZERO(&read_fds);
     int max_fd = -1;
 
-    for (auto& [path, fd] : mouse_devices)
+    for (auto* device : mouse_devices)
     {
-      if (fd < 0)
-        continue;
-
-      FD_SET(fd, &read_fds);
-      if (fd > max_fd)
-        max_fd = fd;
+      FD_SET(device->fd, &read_fds);
+      if (device->fd > max_fd)
+        max_fd = device->fd;
     }
 
     if (max_fd < 0)
@@ -133,28 +131,16 @@ std::string findDevice()
       break;
     }
 
-    std::chrono::microseconds now =
-        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
-
-    auto usec = (deadline - now).count();
-
-    if (usec < 0)
+    if (clock.now() > deadline)
     {
       SPDLOG_INFO("No active device detected");
       break;
     }
 
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = usec;
+    // No timeout means input only, as in the event loop.
+    std::optional<struct timeval> timeout = clock.waitUntil(deadline);
 
-    while (timeout.tv_usec >= 1'000'000)
-    {
-      timeout.tv_sec += 1;
-      timeout.tv_usec -= 1'000'000;
-    }
-
-    int ret = select(max_fd + 1, &read_fds, nullptr, nullptr, &timeout);
+    int ret = select(max_fd + 1, &read_fds, nullptr, nullptr, timeout.has_value() ? &timeout.value() : nullptr);
     if (ret < 0)
     {
       if (errno == EINTR)
@@ -168,151 +154,116 @@ std::string findDevice()
       break;
     }
 
-    for (auto& [path, fd] : mouse_devices)
+    for (auto it = mouse_devices.begin(); it != mouse_devices.end();)
     {
-      if (fd < 0)
+      auto* device = *it;
+      if (!FD_ISSET(device->fd, &read_fds))
+      {
+        ++it;
         continue;
+      }
 
-      if (FD_ISSET(fd, &read_fds))
+      int result;
+      struct input_event ev;
+      while ((result = libevdev_next_event(device->evdev, LIBEVDEV_READ_FLAG_NORMAL, &ev)) ==
+             LIBEVDEV_READ_STATUS_SUCCESS)
       {
-        libevdev* dev = nullptr;
-        int rc = libevdev_new_from_fd(fd, &dev);
-        if (rc < 0)
-        {
-          SPDLOG_INFO("Device {} lost", path);
-          close(fd);
-          fd = -1;
-          continue;
-        }
-
-        int result;
-        struct input_event ev;
-        while ((result = libevdev_next_event(dev, LIBEVDEV_READ_FLAG_NORMAL, &ev)) == LIBEVDEV_READ_STATUS_SUCCESS)
-        {
-          if (ev.type == EV_REL)
-          {
-            SPDLOG_INFO("Active device detected: {}", path);
-            libevdev_free(dev);
-
-            for (auto& [path, fd] : mouse_devices)
-            {
-              if (fd < 0)
-                continue;
-
-              close(fd);
-            }
-
-            return path;
-          }
-        }
-        libevdev_free(dev);
-
-        if (result == -ENODEV)
+        if (ev.type == EV_REL)
         {
-          SPDLOG_INFO("Device {} lost", path);
-          close(fd);
-          fd = -1;
+          SPDLOG_INFO("Active device detected: {} ({})", device->path, device->identity);
+          return device;
         }
       }
-    }
-  }
 
-  for (auto& [path, fd] : mouse_devices)
-  {
-    if (fd < 0)
-      continue;
+      if (result == -ENODEV)
+      {
+        SPDLOG_INFO("Device {} lost", device->path);
+        it = mouse_devices.erase(it);
+        continue;
+      }
 
-    close(fd);
+      ++it;
+    }
   }
 
-  return "";
+  return nullptr;
 }
 
-struct KeyboardDevice
-{
-  int fd;
-  libevdev* evdev;
-  int num_passthrough;
-};
-
-std::vector<KeyboardDevice> findKeyboardDevices(const std::vector<unsigned int>& keys, const std::string& mouse_device)
+std::vector<std::unique_ptr<InputSource>> findKeyboardDevices(DeviceScan& scan, const std::vector<unsigned int>& keys)
 {
-  std::vector<KeyboardDevice> keyboard_devices;
+  std::vector<std::unique_ptr<InputSource>> keyboard_devices;
 
-  if (keys.empty())
+  for (auto& device : scan.devices())
   {
-    return keyboard_devices;
-  }
+    // Taken already, as the mouse.
+    if (device.fd < 0)
+      continue;
 
-  DIR* dir = opendir("/dev/input");
-  if (!dir)
-  {
-    SPDLOG_ERROR("Failed to open /dev/input directory");
-    return keyboard_devices;
-  }
+    bool has_keys = false;
 
-  dirent* entry;
-  while ((entry = readdir(dir)) != nullptr)
-  {
-    std::string_view name = entry->d_name;
-    if (name.rfind("event", 0) == 0)
+    bool is_keyboard = libevdev_has_event_type(device.evdev, EV_KEY);
+    if (is_keyboard)
     {
-      std::string path = "/dev/input/" + std::string(name);
-
-      if (path == mouse_device)
+      for (auto key : keys)
       {
-        continue;
-      }
-
-      int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK);
-      if (fd < 0)
-      {
-        SPDLOG_WARN("Failed to open device {}: {}", path, strerror(errno));
-        continue;
-      }
-
-      libevdev* dev = nullptr;
-      int rc = libevdev_new_from_fd(fd, &dev);
-      if (rc < 0)
-      {
-        SPDLOG_WARN("Failed to initialize libevdev for {}: {}", path, strerror(-rc));
-        close(fd);
-        continue;
-      }
-
-      bool has_keys = false;
-
-      bool is_keyboard = libevdev_has_event_type(dev, EV_KEY);
-      if (is_keyboard)
-      {
-        for (auto key : keys)
+        if (libevdev_has_event_code(device.evdev, EV_KEY, key))
         {
-          if (libevdev_has_event_code(dev, EV_KEY, key))
-          {
-            has_keys = true;
-            break;
-          }
+          has_keys = true;
+          break;
         }
       }
+    }
 
-      if (has_keys)
-      {
-        SPDLOG_INFO("Use keyboard device: {}", path);
-        keyboard_devices.push_back(KeyboardDevice{ fd, dev, 0 });
-      }
-      else
-      {
-        SPDLOG_DEBUG("Device {} is not a valid keyboard", path);
-        close(fd);
-        libevdev_free(dev);
-      }
+    if (has_keys)
+    {
+      SPDLOG_INFO("Use keyboard device: {}", device.path);
+      keyboard_devices.push_back(
+          std::make_unique<EvdevInputSource>(std::exchange(device.fd, -1), std::exchange(device.evdev, nullptr)));
+    }
+    else
+    {
+      SPDLOG_DEBUG("Device {} is not a valid keyboard", device.path);
     }
   }
-  closedir(dir);
 
   return keyboard_devices;
 }
 
+// Calls `read(name, value)` for every smoother option.
+template <typename Read>
+void readSmootherOptions(Read&& read, WheelSmoother::Options& options)
+{
+  // The smoother divides by the tick interval.
+  int tick_interval_microseconds = options.tick_interval_microseconds;
+  read("tick_interval_microseconds", tick_interval_microseconds);
+  if (tick_interval_microseconds > 0)
+  {
+    options.tick_interval_microseconds = tick_interval_microseconds;
+  }
+  else
+  {
+    SPDLOG_ERROR("tick_interval_microseconds must be positive, using {}", options.tick_interval_microseconds);
+  }
+  read("min_deceleration", options.min_deceleration);
+  read("max_deceleration", options.max_deceleration);
+  read("initial_speed", options.initial_speed);
+  read("speed_factor", options.speed_factor);
+  read("speed_smooth_window_microseconds", options.speed_smooth_window_microseconds);
+  read("max_speed_change_lowerbound", options.max_speed_change_lowerbound);
+  read("min_speed_change_upperbound", options.min_speed_change_upperbound);
+  read("min_speed_change_ratio", options.min_speed_change_ratio);
+  read("max_speed_change_ratio", options.max_speed_change_ratio);
+  read("damping", options.damping);
+  read("use_reverse_scroll_braking", options.use_reverse_scroll_braking);
+  read("max_reverse_scroll_braking_microseconds", options.max_reverse_scroll_braking_microseconds);
+  read("max_reverse_scroll_braking_times", options.max_reverse_scroll_braking_times);
+  read("use_mouse_movement_braking", options.use_mouse_movement_braking);
+  read("max_mouse_movement_distance", options.max_mouse_movement_distance);
+  read("mouse_movement_window_milliseconds", options.mouse_movement_window_milliseconds);
+  read("mouse_movement_delay_microseconds", options.mouse_movement_delay_microseconds);
+  read("drag_view_speed", options.drag_view_speed);
+}
+
 void waitUntilAllButtonsReleased(libevdev* evdev, const std::vector<int>& supported_buttons)
 {
   auto are_any_buttons_pressed = [&]() -> bool {
@@ -354,6 +305,9 @@ int main(int argc, char* argv[])
 {
   spdlog::set_pattern("[%E.%f] [%^%L%$] %v");
 
+  // Debug messages from the input path are formatted on a background thread so they don't disturb tick timing.
+  BinaryLog debug_log;
+
   std::string config_path(kDefaultConfigPath);
   bool show_help = false;
   bool show_version = false;
@@ -374,6 +328,7 @@ int main(int argc, char* argv[])
     else if (arg == "-d" || arg == "--debug")
     {
       spdlog::set_level(spdlog::level::debug);
+      debug_log.start();
     }
     else if ((arg == "-c" || arg == "--config"))
     {
@@ -428,16 +383,6 @@ int main(int argc, char* argv[])
   }
 
   std::optional<std::string> device = table["device"].value<std::string>();
-  if (!device.has_value())
-  {
-    SPDLOG_INFO("No 'device' field in config file");
-
-    device = findDevice();
-    if ((*device).empty())
-    {
-      return -1;
-    }
-  }
 
   int free_spin_button = BTN_RIGHT;
   if (auto opt = table["free_spin_button"].value<int>())
@@ -502,509 +447,264 @@ int main(int argc, char* argv[])
   };
 
   WheelSmoother::Options options;
-  read_option("tick_interval_microseconds", options.tick_interval_microseconds);
-  read_option("min_deceleration", options.min_deceleration);
-  read_option("max_deceleration", options.max_deceleration);
-  read_option("initial_speed", options.initial_speed);
-  read_option("speed_factor", options.speed_factor);
-  read_option("speed_smooth_window_microseconds", options.speed_smooth_window_microseconds);
-  read_option("max_speed_change_lowerbound", options.max_speed_change_lowerbound);
-  read_option("min_speed_change_upperbound", options.min_speed_change_upperbound);
-  read_option("min_speed_change_ratio", options.min_speed_change_ratio);
-  read_option("max_speed_change_ratio", options.max_speed_change_ratio);
-  read_option("damping", options.damping);
-  read_option("use_reverse_scroll_braking", options.use_reverse_scroll_braking);
-  read_option("max_reverse_scroll_braking_microseconds", options.max_reverse_scroll_braking_microseconds);
-  read_option("max_reverse_scroll_braking_times", options.max_reverse_scroll_braking_times);
-  read_option("use_mouse_movement_braking", options.use_mouse_movement_braking);
-  read_option("max_mouse_movement_distance", options.max_mouse_movement_distance);
-  read_option("mouse_movement_window_milliseconds", options.mouse_movement_window_milliseconds);
-  read_option("mouse_movement_delay_microseconds", options.mouse_movement_delay_microseconds);
-  read_option("drag_view_speed", options.drag_view_speed);
-
-  if (signal(SIGINT, signalHandler) == SIG_ERR)
-  {
-    SPDLOG_ERROR("can't catch SIGINT");
-    return -1;
-  }
+  readSmootherOptions(read_option, options);
 
-  int mouse_fd = open((*device).c_str(), O_RDONLY | O_NONBLOCK);
-  if (mouse_fd < 0)
-  {
-    SPDLOG_ERROR("can't open {}", *device);
-    return -1;
-  }
+  bool legacy_wheel_events = false;
+  read_option("legacy_wheel_events", legacy_wheel_events);
 
-  struct libevdev* mouse_evdev = nullptr;
-  int rc = libevdev_new_from_fd(mouse_fd, &mouse_evdev);
-  if (rc < 0)
+  int output_period_microseconds = 0;
+  read_option("output_period_microseconds", output_period_microseconds);
+
+  int output_phase_microseconds = 0;
+  read_option("output_phase_microseconds", output_phase_microseconds);
+
+  bool split_virtual_devices = false;
+  read_option("split_virtual_devices", split_virtual_devices);
+
+  RealtimeOptions realtime_options;
+  read_option("realtime_priority", realtime_options.priority);
+  read_option("lock_memory", realtime_options.lock_memory);
+  if (table["cpu_affinity"].value<std::string>() == "auto")
   {
-    SPDLOG_ERROR("failed to initialize libevdev: {}", strerror(-rc));
-    close(mouse_fd);
-    return -1;
+    realtime_options.auto_cpu = true;
+    SPDLOG_INFO("Config loaded: cpu_affinity = auto");
   }
-
-  int uinput_fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
-  if (uinput_fd < 0)
+  else
   {
-    SPDLOG_ERROR("failed to open /dev/uinput");
-    libevdev_free(mouse_evdev);
-    close(mouse_fd);
-    return -1;
+    read_option("cpu_affinity", realtime_options.cpu);
   }
 
-  std::vector<int> supported_buttons;
+  int64_t scroll_timer_slack_ns = 0;
+  read_option("scroll_timer_slack_ns", scroll_timer_slack_ns);
+
+  bool auto_calibration = false;
+  read_option("auto_calibration", auto_calibration);
+
+  bool session_journal = true;
+  read_option("session_journal", session_journal);
+
+  std::string metrics_file;
+  read_option("metrics_file", metrics_file);
 
-  SPDLOG_INFO("Input device name: \"{}\"", libevdev_get_name(mouse_evdev));
-  SPDLOG_INFO("Input device ID: bus {:#x} vendor {:#x} product {:#x}", libevdev_get_id_bustype(mouse_evdev),
-              libevdev_get_id_vendor(mouse_evdev), libevdev_get_id_product(mouse_evdev));
+  int64_t metrics_interval_seconds = 15;
+  read_option("metrics_interval_seconds", metrics_interval_seconds);
 
-  for (int type = 0; type < EV_MAX; type++)
+  // systemd stops the service with SIGTERM, and shutting down cleanly is what saves a calibration profile.
+  for (int signal_num : { SIGINT, SIGTERM })
   {
-    if (libevdev_has_event_type(mouse_evdev, type))
+    if (signal(signal_num, signalHandler) == SIG_ERR)
     {
-      const char* type_name = libevdev_event_type_get_name(type);
-      SPDLOG_INFO("  Event type {} ({}) supported", type, type_name ? type_name : "?");
-
-      if (type == EV_KEY)
-      {
-        ioctl(uinput_fd, UI_SET_EVBIT, type);
-        for (int code = 0; code < KEY_MAX; code++)
-        {
-          if (libevdev_has_event_code(mouse_evdev, type, code))
-          {
-            const char* code_name = libevdev_event_code_get_name(type, code);
-            SPDLOG_INFO("    Event code {} ({})", code, code_name ? code_name : "?");
-            ioctl(uinput_fd, UI_SET_KEYBIT, code);
-            supported_buttons.push_back(code);
-          }
-        }
-      }
-      else if (type == EV_REL)
-      {
-        ioctl(uinput_fd, UI_SET_EVBIT, type);
-        for (int code = 0; code < REL_MAX; code++)
-        {
-          if (libevdev_has_event_code(mouse_evdev, type, code))
-          {
-            const char* code_name = libevdev_event_code_get_name(type, code);
-            SPDLOG_INFO("    Event code {} ({})", code, code_name ? code_name : "?");
-            ioctl(uinput_fd, UI_SET_RELBIT, code);
-          }
-        }
-      }
-      else if (type == EV_MSC)
-      {
-        ioctl(uinput_fd, UI_SET_EVBIT, type);
-        for (int code = 0; code < MSC_MAX; code++)
-        {
-          if (libevdev_has_event_code(mouse_evdev, type, code))
-          {
-            const char* code_name = libevdev_event_code_get_name(type, code);
-            SPDLOG_INFO("    Event code {} ({})", code, code_name ? code_name : "?");
-            ioctl(uinput_fd, UI_SET_MSCBIT, code);
-          }
-        }
-      }
+      SPDLOG_ERROR("can't catch signal {}", signal_num);
+      return -1;
     }
   }
 
-  struct uinput_user_dev uidev;
-  memset(&uidev, 0, sizeof(uidev));
-  snprintf(uidev.name, UINPUT_MAX_NAME_SIZE, "Virtual Smooth Mouse");
-  uidev.id.bustype = BUS_USB;
-  uidev.id.vendor = 0x1234;
-  uidev.id.product = 0x5678;
-  uidev.id.version = 1;
+  std::vector<unsigned int> keys;
+  keys.reserve(keyboard_braking_keys.size() + keyboard_passthrough_keys.size());
+  keys.insert(keys.end(), keyboard_braking_keys.begin(), keyboard_braking_keys.end());
+  keys.insert(keys.end(), keyboard_passthrough_keys.begin(), keyboard_passthrough_keys.end());
 
-  if (write(uinput_fd, &uidev, sizeof(uidev)) < 0)
-  {
-    SPDLOG_ERROR("Write uidev failed");
-    close(uinput_fd);
-    libevdev_free(mouse_evdev);
-    close(mouse_fd);
-    return -1;
-  }
+  std::string state_directory = stateDirectory();
 
-  if (ioctl(uinput_fd, UI_DEV_CREATE) < 0)
-  {
-    SPDLOG_ERROR("Unable to create uinput device");
-    close(uinput_fd);
-    libevdev_free(mouse_evdev);
-    close(mouse_fd);
-    return -1;
-  }
+  // One scan finds both the mouse, unless the config names it, and the keyboards.
+  DeviceScan scan;
+  int mouse_fd = -1;
+  struct libevdev* mouse_evdev = nullptr;
 
-  int num_passthrough = 0;
-  std::array<bool, KEY_CNT> braking_keys_table{};
-  std::array<bool, KEY_CNT> passthrough_keys_table{};
-  std::vector<KeyboardDevice> keyboard_devices;
-  if (!keyboard_braking_keys.empty() || !keyboard_passthrough_keys.empty())
+  if (device.has_value())
   {
-    std::vector<unsigned int> keys;
-    keys.reserve(keyboard_braking_keys.size() + keyboard_passthrough_keys.size());
-    keys.insert(keys.end(), keyboard_braking_keys.begin(), keyboard_braking_keys.end());
-    keys.insert(keys.end(), keyboard_passthrough_keys.begin(), keyboard_passthrough_keys.end());
-
-    for (auto key : keys)
+    mouse_fd = open((*device).c_str(), O_RDONLY | O_NONBLOCK);
+    if (mouse_fd < 0)
     {
-      braking_keys_table[key] = true;
+      SPDLOG_ERROR("can't open {}", *device);
+      return -1;
     }
 
-    for (auto key : keyboard_passthrough_keys)
+    int rc = libevdev_new_from_fd(mouse_fd, &mouse_evdev);
+    if (rc < 0)
     {
-      passthrough_keys_table[key] = true;
+      SPDLOG_ERROR("failed to initialize libevdev: {}", strerror(-rc));
+      close(mouse_fd);
+      return -1;
     }
 
-    keyboard_devices = findKeyboardDevices(keys, *device);
-  }
-
-  waitUntilAllButtonsReleased(mouse_evdev, supported_buttons);
-
-  auto cleanup = [&]() {
-    libevdev_grab(mouse_evdev, LIBEVDEV_UNGRAB);
-    ioctl(uinput_fd, UI_DEV_DESTROY);
-    close(uinput_fd);
-    libevdev_free(mouse_evdev);
-    close(mouse_fd);
-    for (const auto& dev : keyboard_devices)
+    if (!keys.empty())
     {
-      libevdev_free(dev.evdev);
-      close(dev.fd);
+      scan.run(*device);
     }
-  };
-
-  if (libevdev_grab(mouse_evdev, LIBEVDEV_GRAB) < 0)
-  {
-    SPDLOG_ERROR("failed to grab mouse_evdev");
-    cleanup();
-    return -1;
   }
+  else
+  {
+    SPDLOG_INFO("No 'device' field in config file");
 
-  ipc.setConnected();
-
-  WheelSmoother wheel_smoother{ options };
+    if (!scan.run())
+    {
+      return -1;
+    }
 
-  int max_fd;
-  fd_set fds;
+    std::string last_device_path = state_directory.empty() ? "" : state_directory + "/last-device";
+    LastDevice last = last_device_path.empty() ? LastDevice{} : loadLastDevice(last_device_path);
 
-  auto set_fds = [&]() {
-    max_fd = mouse_fd;
-    FD_ZERO(&fds);
-    FD_SET(mouse_fd, &fds);
-    for (const auto& dev : keyboard_devices)
+    auto* found = findDevice(scan, last, SystemClock::instance());
+    if (!found)
     {
-      FD_SET(dev.fd, &fds);
-      if (dev.fd > max_fd)
-      {
-        max_fd = dev.fd;
-      }
+      return -1;
     }
-  };
 
-  set_fds();
-
-  struct input_event ev;
-  std::vector<struct input_event> events;
-  events.reserve(16);
+    if (!last_device_path.empty() && (found->identity != last.identity || found->phys != last.phys))
+    {
+      saveLastDevice(last_device_path, *found);
+    }
 
-  auto write_events = [&](const timeval& time) -> bool {
-    if (events.empty())
-      return true;
+    device = found->path;
+    mouse_fd = std::exchange(found->fd, -1);
+    mouse_evdev = std::exchange(found->evdev, nullptr);
+  }
 
-    events.push_back({ time, EV_SYN, SYN_REPORT, 0 });
-    ssize_t expected_bytes = events.size() * sizeof(struct input_event);
-    ssize_t bytes_written = write(uinput_fd, events.data(), expected_bytes);
-    events.clear();
-    return bytes_written == expected_bytes;
-  };
+  EvdevInputSource mouse{ mouse_fd, mouse_evdev };
 
-  while (!kShutdown.load(std::memory_order_relaxed))
+  // A measured profile scales the options to how this model's wheel is spun and how fast its sensor reports; without
+  // one, measure it now.
+  std::optional<DeviceCalibrator> calibrator;
+  if (auto_calibration && !state_directory.empty())
   {
-    fd_set read_fds = fds;
-
-    auto timeout = wheel_smoother.timeout();
-
-    int select_ret = select(max_fd + 1, &read_fds, NULL, NULL, timeout.has_value() ? &timeout.value() : NULL);
-    if (select_ret < 0)
+    std::string profile_path = fmt::format("{}/profiles/{:04x}-{:04x}.toml", state_directory,
+                                           libevdev_get_id_vendor(mouse_evdev), libevdev_get_id_product(mouse_evdev));
+    if (access(profile_path.c_str(), R_OK) == 0)
     {
-      if (errno == EINTR)
+      try
       {
-        SPDLOG_TRACE("select errno EINTR");
-        continue;
+        auto profile_table = toml::parse_file(profile_path);
+        DeviceProfile profile;
+        profile.wheel_notch_interval =
+            std::chrono::microseconds{ profile_table["wheel_notch_interval_microseconds"].value_or(0) };
+        profile.report_interval =
+            std::chrono::microseconds{ profile_table["report_interval_microseconds"].value_or(0) };
+        applyDeviceProfile(profile, options);
       }
-
-      SPDLOG_ERROR("select error: {}", select_ret);
-      break;
-    }
-    else if (select_ret == 0)
-    {
-      if (ipc.checkBrakeSignal() || ipc.isForcePassthroughEnabled())
+      catch (const toml::parse_error& err)
       {
-        wheel_smoother.stop();
+        SPDLOG_WARN("Parsing {} failed: {}", profile_path, err.description());
       }
-      else
-      {
-        if (auto ev_wheel = wheel_smoother.tick())
-        {
-          events.push_back(*ev_wheel);
-          if (!write_events(ev_wheel->time))
-          {
-            SPDLOG_ERROR("Write uinput failed");
-            cleanup();
-            return -1;
-          }
-        }
-      }
-
-      ipc.setSpeed(wheel_smoother.speed(), wheel_smoother.positive(), wheel_smoother.horizontal());
-      continue;
     }
-
-    for (auto it = keyboard_devices.begin(); it != keyboard_devices.end();)
+    else
     {
-      const unsigned int fd = it->fd;
+      SPDLOG_INFO("No profile for this device yet, calibrating while in use and saving it at exit");
+      calibrator.emplace(profile_path, libevdev_get_name(mouse_evdev));
+    }
+  }
 
-      if (!FD_ISSET(fd, &read_fds))
-      {
-        ++it;
-        continue;
-      }
+  std::vector<int> supported_buttons;
+  UinputOutputSink output;
+  if (!output.create(mouse_evdev, supported_buttons,
+                     split_virtual_devices ? UinputOutputSink::Role::kPointer : UinputOutputSink::Role::kClone))
+  {
+    return -1;
+  }
 
-      libevdev* evdev = it->evdev;
+  // The wheel device's placeholder button is never pressed, so it is left out of the buttons to wait for.
+  std::optional<UinputOutputSink> wheel_output;
+  if (split_virtual_devices)
+  {
+    std::vector<int> wheel_buttons;
+    if (!wheel_output.emplace().create(mouse_evdev, wheel_buttons, UinputOutputSink::Role::kWheel))
+    {
+      return -1;
+    }
+  }
 
-      int result;
-      int read_flag = LIBEVDEV_READ_FLAG_NORMAL;
-      while (true)
-      {
-        result = libevdev_next_event(evdev, read_flag, &ev);
+  std::vector<std::unique_ptr<InputSource>> keyboard_devices;
+  if (!keys.empty())
+  {
+    keyboard_devices = findKeyboardDevices(scan, keys);
+  }
 
-        if (result == LIBEVDEV_READ_STATUS_SYNC)
-        {
-          if (ev.type == EV_SYN && ev.code == SYN_DROPPED)
-          {
-            read_flag = LIBEVDEV_READ_FLAG_SYNC;
-            continue;
-          }
-        }
-        else if (result != LIBEVDEV_READ_STATUS_SUCCESS)
-        {
-          break;
-        }
+  // Nothing else is taken from the scan, so the devices left in it are not held open for the life of the daemon.
+  scan.release();
 
-        if (ev.type == EV_KEY && ev.code < KEY_CNT && ev.value != 2)
-        {
-          if (braking_keys_table[ev.code])
-          {
-            if (wheel_smoother.speed() != 0)
-            {
-              ipc.setSpeed(0, false, false);
-            }
-            wheel_smoother.stop();
-          }
-
-          if (passthrough_keys_table[ev.code])
-          {
-            if (ev.value == 1)
-            {
-              ++it->num_passthrough;
-              ++num_passthrough;
-            }
-            else
-            {
-              if (it->num_passthrough)
-              {
-                --it->num_passthrough;
-                --num_passthrough;
-              }
-            }
-            ipc.setPassthrough(num_passthrough);
-          }
-        }
-      }
+  waitUntilAllButtonsReleased(mouse_evdev, supported_buttons);
 
-      if (result == -ENODEV)
-      {
-        SPDLOG_WARN("Keyboard device lost");
-        libevdev_free(evdev);
-        close(fd);
-        num_passthrough -= it->num_passthrough;
-        ipc.setPassthrough(num_passthrough);
+  if (!mouse.grab())
+  {
+    SPDLOG_ERROR("failed to grab mouse_evdev");
+    return -1;
+  }
 
-        it = keyboard_devices.erase(it);
+  ipc.setConnected();
 
-        set_fds();
-        continue;
+  EventLoop::Options loop_options;
+  loop_options.free_spin_button = free_spin_button;
+  loop_options.drag_view_button = drag_view_button;
+  loop_options.keyboard_braking_keys = keyboard_braking_keys;
+  loop_options.keyboard_passthrough_keys = keyboard_passthrough_keys;
+  loop_options.legacy_wheel_events = legacy_wheel_events;
+  loop_options.output_period_microseconds = std::max(output_period_microseconds, 0);
+  loop_options.output_phase_microseconds = std::max(output_phase_microseconds, 0);
+  loop_options.split_wheel_output = split_virtual_devices;
+  loop_options.scroll_timer_slack_ns = std::max<int64_t>(scroll_timer_slack_ns, 0);
+
+  // An enabled [shadow] table runs its smoother options next to the live ones on the same input, without output.
+  // Started before the realtime settings so that its thread stays an ordinary one.
+  std::optional<ShadowSmoother> shadow;
+  if (auto shadow_table = table["shadow"].as_table(); shadow_table && (*shadow_table)["enabled"].value_or(false))
+  {
+    WheelSmoother::Options shadow_options = options;
+    auto read_shadow_option = [shadow_table](const char* name, auto& value) {
+      if (auto opt = (*shadow_table)[name].value<std::remove_reference_t<decltype(value)>>())
+      {
+        value = *opt;
+        SPDLOG_INFO("Shadow config loaded: {} = {}", name, value);
       }
+    };
+    readSmootherOptions(read_shadow_option, shadow_options);
 
-      ++it;
-    }
+    shadow.emplace(loop_options, options, shadow_options, (*shadow_table)["log_file"].value_or(std::string{}));
+    shadow->start();
+  }
 
-    if (FD_ISSET(mouse_fd, &read_fds))
-    {
-      int result;
-      int read_flag = LIBEVDEV_READ_FLAG_NORMAL;
-      while (true)
-      {
-        result = libevdev_next_event(mouse_evdev, read_flag, &ev);
+  // Mapped before the realtime settings so that its pages are faulted in before memory is locked.
+  SessionJournal journal;
+  bool journal_open =
+      session_journal && !state_directory.empty() && journal.open(state_directory + "/sessions.journal");
 
-        if (result == LIBEVDEV_READ_STATUS_SYNC)
-        {
-          if (ev.type == EV_SYN && ev.code == SYN_DROPPED)
-          {
-            read_flag = LIBEVDEV_READ_FLAG_SYNC;
-            continue;
-          }
-        }
-        else if (result != LIBEVDEV_READ_STATUS_SUCCESS)
-        {
-          break;
-        }
+  // Like the shadow smoother's, its thread is started before the realtime settings.
+  Metrics metrics;
+  std::optional<MetricsWriter> metrics_writer;
+  if (!metrics_file.empty())
+  {
+    auto interval = std::chrono::seconds{ std::max<int64_t>(metrics_interval_seconds, 1) };
+    metrics_writer.emplace(metrics, metrics_file, interval);
+    metrics_writer->start();
+  }
 
-        switch (ev.type)
-        {
-          case EV_REL:
-            switch (ev.code)
-            {
-              case REL_WHEEL:
-              case REL_HWHEEL:
-                if (num_passthrough || ipc.isForcePassthroughEnabled())
-                {
-                  events.push_back(ev);
-                }
-                else
-                {
-                  if (ipc.checkBrakeSignal())
-                  {
-                    wheel_smoother.stop();
-                  }
-
-                  if (auto ev_wheel = wheel_smoother.handleEvent(ev.time, ev.value > 0, ev.code == REL_HWHEEL))
-                  {
-                    events.push_back(*ev_wheel);
-                  }
-
-                  ipc.setSpeed(wheel_smoother.speed(), wheel_smoother.positive(), wheel_smoother.horizontal());
-                }
-                break;
-
-              case REL_WHEEL_HI_RES:
-              case REL_HWHEEL_HI_RES:
-                if (num_passthrough || ipc.isForcePassthroughEnabled())
-                {
-                  events.push_back(ev);
-                }
-                break;
-
-              case REL_X:
-                wheel_smoother.handleRelXEvent(ev);
-                events.push_back(ev);
-                break;
-
-              case REL_Y:
-                wheel_smoother.handleRelYEvent(ev);
-                events.push_back(ev);
-                break;
-
-              default:
-                events.push_back(ev);
-                break;
-            }
-            break;
-
-          case EV_KEY: {
-            bool handled = false;
-
-            if (ev.code == drag_view_button)
-            {
-              if ((handled = wheel_smoother.handleDragViewButton(ev.value)))
-              {
-                ipc.setDragView(wheel_smoother.drag_view());
-              }
-            }
-            else if (ev.code == free_spin_button)
-            {
-              if ((handled = wheel_smoother.handleFreeSpinButton(ev.value)))
-              {
-                ipc.setFreeSpin(wheel_smoother.free_spin());
-              }
-            }
-
-            if (!handled)
-            {
-              if (wheel_smoother.speed() != 0)
-              {
-                ipc.setSpeed(0, false, false);
-              }
-              wheel_smoother.stop();
-              events.push_back(ev);
-            }
-            break;
-          }
-
-          case EV_MSC:
-            break;
-
-          case EV_SYN:
-            if (ev.code == SYN_REPORT)
-            {
-              if (wheel_smoother.handleReportEvent(ev.time))
-              {
-                ipc.setSpeed(0, false, false);
-              }
-
-              if (!write_events(ev.time))
-              {
-                SPDLOG_ERROR("Write uinput failed");
-                cleanup();
-                return -1;
-              }
-            }
-            break;
-
-          default:
-            events.push_back(ev);
-            break;
-        }
-      }
+  applyRealtime(realtime_options);
 
-      if (result == -ENODEV)
-      {
-        SPDLOG_ERROR("Mouse device lost");
-        cleanup();
-        return -1;
-      }
-    }
+  EventLoop loop{ loop_options, options, ipc, mouse, std::move(keyboard_devices), output,
+                  wheel_output ? &*wheel_output : nullptr };
+  if (calibrator)
+  {
+    loop.setCalibrator(&*calibrator);
+  }
+  if (shadow)
+  {
+    loop.setShadow(&*shadow);
+  }
+  if (journal_open)
+  {
+    loop.setJournal(&journal);
+  }
+  if (metrics_writer)
+  {
+    loop.setMetrics(&metrics);
+  }
 
-    if (auto next_tick_time = wheel_smoother.next_tick_time())
-    {
-      std::chrono::microseconds event_time =
-          std::chrono::seconds{ ev.time.tv_sec } + std::chrono::microseconds{ ev.time.tv_usec };
-      if (event_time > *next_tick_time)
-      {
-        if (ipc.checkBrakeSignal() || ipc.isForcePassthroughEnabled())
-        {
-          wheel_smoother.stop();
-        }
-        else
-        {
-          if (auto ev_wheel = wheel_smoother.tick())
-          {
-            events.push_back(*ev_wheel);
-            if (!write_events(ev_wheel->time))
-            {
-              SPDLOG_ERROR("Write uinput failed");
-              cleanup();
-              return -1;
-            }
-          }
-        }
+  bool ok = loop.run(kShutdown);
 
-        ipc.setSpeed(wheel_smoother.speed(), wheel_smoother.positive(), wheel_smoother.horizontal());
-      }
-    }
+  // Written only now, so that measuring costs the input path no allocation or file I/O.
+  if (calibrator)
+  {
+    calibrator->save();
   }
 
-  cleanup();
-  return 0;
+  return ok ? 0 : -1;
 }
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include <smoothscroll.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+#include "event_router.h"
+
+using smooth_scroll::EventRouter;
+using smooth_scroll::WheelSmoother;
+
+struct smoothscroll
+{
+  EventRouter::Options options;
+  WheelSmoother::Options smoother_options;
+
+  // Created by the first event, after which options are fixed.
+  std::optional<EventRouter> router;
+  bool force_passthrough = false;
+  std::map<int, int> keyboards;  // passthrough keys held per keyboard id
+  size_t pulled = 0;
+
+  EventRouter& started()
+  {
+    if (!router)
+    {
+      router.emplace(options, smoother_options);
+      router->setForcePassthrough(force_passthrough);
+    }
+    return *router;
+  }
+};
+
+namespace
+{
+
+using Field = std::variant<int WheelSmoother::Options::*, double WheelSmoother::Options::*,
+                           bool WheelSmoother::Options::*, int EventRouter::Options::*, bool EventRouter::Options::*>;
+
+struct NamedField
+{
+  std::string_view name;
+  Field field;
+};
+
+const NamedField kFields[] = {
+  { "tick_interval_microseconds", &WheelSmoother::Options::tick_interval_microseconds },
+  { "min_deceleration", &WheelSmoother::Options::min_deceleration },
+  { "max_deceleration", &WheelSmoother::Options::max_deceleration },
+  { "initial_speed", &WheelSmoother::Options::initial_speed },
+  { "speed_factor", &WheelSmoother::Options::speed_factor },
+  { "speed_smooth_window_microseconds", &WheelSmoother::Options::speed_smooth_window_microseconds },
+  { "max_speed_change_lowerbound", &WheelSmoother::Options::max_speed_change_lowerbound },
+  { "min_speed_change_upperbound", &WheelSmoother::Options::min_speed_change_upperbound },
+  { "min_speed_change_ratio", &WheelSmoother::Options::min_speed_change_ratio },
+  { "max_speed_change_ratio", &WheelSmoother::Options::max_speed_change_ratio },
+  { "damping", &WheelSmoother::Options::damping },
+  { "use_reverse_scroll_braking", &WheelSmoother::Options::use_reverse_scroll_braking },
+  { "max_reverse_scroll_braking_microseconds", &WheelSmoother::Options::max_reverse_scroll_braking_microseconds },
+  { "max_reverse_scroll_braking_times", &WheelSmoother::Options::max_reverse_scroll_braking_times },
+  { "use_mouse_movement_braking", &WheelSmoother::Options::use_mouse_movement_braking },
+  { "max_mouse_movement_distance", &WheelSmoother::Options::max_mouse_movement_distance },
+  { "mouse_movement_window_milliseconds", &WheelSmoother::Options::mouse_movement_window_milliseconds },
+  { "mouse_movement_delay_microseconds", &WheelSmoother::Options::mouse_movement_delay_microseconds },
+  { "drag_view_speed", &WheelSmoother::Options::drag_view_speed },
+  { "free_spin_button", &EventRouter::Options::free_spin_button },
+  { "drag_view_button", &EventRouter::Options::drag_view_button },
+  { "legacy_wheel_events", &EventRouter::Options::legacy_wheel_events },
+  { "output_period_microseconds", &EventRouter::Options::output_period_microseconds },
+  { "output_phase_microseconds", &EventRouter::Options::output_phase_microseconds },
+};
+
+struct FieldSetter
+{
+  smoothscroll* ss;
+  double value;
+
+  void operator()(int WheelSmoother::Options::*field) const
+  {
+    ss->smoother_options.*field = static_cast<int>(value);
+  }
+
+  void operator()(double WheelSmoother::Options::*field) const
+  {
+    ss->smoother_options.*field = value;
+  }
+
+  void operator()(bool WheelSmoother::Options::*field) const
+  {
+    ss->smoother_options.*field = value != 0;
+  }
+
+  void operator()(int EventRouter::Options::*field) const
+  {
+    ss->options.*field = static_cast<int>(value);
+  }
+
+  void operator()(bool EventRouter::Options::*field) const
+  {
+    ss->options.*field = value != 0;
+  }
+};
+
+// Nothing may unwind through the C API, so every entry point that can throw runs through this and reports an
+// exception as `failure`.
+template <typename Result, typename Function>
+Result guarded(Result failure, Function&& function) noexcept
+{
+  try
+  {
+    return function();
+  }
+  catch (...)
+  {
+    return failure;
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+int smoothscroll_api_version(void)
+{
+  return SMOOTHSCROLL_API_VERSION;
+}
+
+smoothscroll* smoothscroll_create(void)
+{
+  return new (std::nothrow) smoothscroll{};
+}
+
+void smoothscroll_destroy(smoothscroll* ss)
+{
+  delete ss;
+}
+
+int smoothscroll_set_option(smoothscroll* ss, const char* name, double value)
+{
+  if (ss->router)
+    return -1;
+
+  for (const auto& named_field : kFields)
+  {
+    if (named_field.name == name)
+    {
+      // The smoother divides by the tick interval.
+      if (named_field.field == Field{ &WheelSmoother::Options::tick_interval_microseconds } && !(value >= 1))
+        return -1;
+
+      std::visit(FieldSetter{ ss, value }, named_field.field);
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+int smoothscroll_add_braking_key(smoothscroll* ss, unsigned int code)
+{
+  if (ss->router || code >= KEY_CNT)
+    return -1;
+
+  return guarded(-1, [&] {
+    ss->options.keyboard_braking_keys.push_back(code);
+    return 0;
+  });
+}
+
+int smoothscroll_add_passthrough_key(smoothscroll* ss, unsigned int code)
+{
+  if (ss->router || code >= KEY_CNT)
+    return -1;
+
+  return guarded(-1, [&] {
+    ss->options.keyboard_passthrough_keys.push_back(code);
+    return 0;
+  });
+}
+
+int smoothscroll_feed_mouse(smoothscroll* ss, const struct input_event* ev)
+{
+  return guarded(-1, [&] {
+    ss->started().handleMouseEvent(*ev);
+    return 0;
+  });
+}
+
+int smoothscroll_feed_keyboard(smoothscroll* ss, int keyboard, const struct input_event* ev)
+{
+  return guarded(-1, [&] {
+    ss->started().handleKeyboardEvent(*ev, ss->keyboards[keyboard]);
+    return 0;
+  });
+}
+
+void smoothscroll_remove_keyboard(smoothscroll* ss, int keyboard)
+{
+  // Never allocates: a keyboard is only known once its first event has started the router.
+  auto it = ss->keyboards.find(keyboard);
+  if (it == ss->keyboards.end())
+    return;
+
+  if (ss->router)
+  {
+    ss->router->removeKeyboard(it->second);
+  }
+  ss->keyboards.erase(it);
+}
+
+int64_t smoothscroll_next_deadline(const smoothscroll* ss)
+{
+  if (!ss->router)
+    return -1;
+
+  auto next_tick_time = ss->router->next_tick_time();
+  return next_tick_time ? next_tick_time->count() : -1;
+}
+
+int smoothscroll_tick(smoothscroll* ss)
+{
+  return guarded(-1, [&] {
+    auto& router = ss->started();
+    auto next_tick_time = router.next_tick_time();
+    return next_tick_time && router.tick(*next_tick_time) ? 1 : 0;
+  });
+}
+
+int smoothscroll_advance(smoothscroll* ss, int64_t now)
+{
+  return guarded(-1, [&] {
+    auto& router = ss->started();
+    auto next_tick_time = router.next_tick_time();
+    if (!next_tick_time || next_tick_time->count() > now)
+      return 0;
+
+    return router.tick(std::chrono::microseconds{ now }) ? 1 : 0;
+  });
+}
+
+size_t smoothscroll_pull(smoothscroll* ss, struct input_event* events, size_t capacity)
+{
+  if (!ss->router)
+    return 0;
+
+  const auto& output = ss->router->output();
+  size_t count = std::min(capacity, output.size() - ss->pulled);
+  if (count)
+  {
+    std::memcpy(events, output.data() + ss->pulled, count * sizeof(struct input_event));
+  }
+
+  ss->pulled += count;
+  if (ss->pulled == output.size())
+  {
+    ss->router->clearOutput();
+    ss->pulled = 0;
+  }
+
+  return count;
+}
+
+void smoothscroll_brake(smoothscroll* ss)
+{
+  if (ss->router)
+  {
+    ss->router->brake();
+  }
+}
+
+void smoothscroll_set_passthrough(smoothscroll* ss, int enabled)
+{
+  ss->force_passthrough = enabled != 0;
+  if (ss->router)
+  {
+    ss->router->setForcePassthrough(ss->force_passthrough);
+  }
+}
+
+double smoothscroll_speed(const smoothscroll* ss)
+{
+  return ss->router ? ss->router->state().speed : 0;
+}
+
+}  // extern "C"
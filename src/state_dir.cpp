@@ -0,0 +1,52 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "state_dir.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+void makeDirectories(const std::string& path)
+{
+  for (auto slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+  {
+    mkdir(path.substr(0, slash).c_str(), 0755);
+  }
+}
+
+bool writeStateFile(const std::string& path, const std::string& contents)
+{
+  makeDirectories(path);
+
+  // Written next to the old file and renamed over it, so a crash never leaves half a file behind.
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    file << contents;
+    if (!file.flush())
+    {
+      SPDLOG_WARN("Failed to write {}", path);
+      return false;
+    }
+  }
+
+  if (rename(tmp_path.c_str(), path.c_str()) < 0)
+  {
+    SPDLOG_WARN("Failed to write {}: {}", path, strerror(errno));
+    unlink(tmp_path.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace smooth_scroll
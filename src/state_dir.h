@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <string>
+
+namespace smooth_scroll
+{
+
+// Creates the missing parent directories of `path`, as for files under /var/lib/smooth-scroll and
+// /run/smooth-scroll that may be the first in their directory.
+void makeDirectories(const std::string& path);
+
+// Replaces the file at `path` with `contents` in one step, creating missing directories on the way.
+bool writeStateFile(const std::string& path, const std::string& contents);
+
+}  // namespace smooth_scroll
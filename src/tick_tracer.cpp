@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "tick_tracer.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace smooth_scroll
+{
+
+void TickTracer::setEnabled(bool enabled) noexcept
+{
+  if (enabled == enabled_)
+  {
+    return;
+  }
+
+  enabled_ = enabled;
+  SPDLOG_INFO("Tick tracer {}", enabled ? "enabled" : "disabled");
+
+  if (enabled)
+  {
+    begin(clock_.now());
+  }
+}
+
+void TickTracer::onWakeup(Wakeup cause) noexcept
+{
+  if (!enabled_)
+  {
+    return;
+  }
+
+  ++counters_.wakeups[static_cast<size_t>(cause)];
+}
+
+void TickTracer::onTick(std::chrono::microseconds scheduled, bool output) noexcept
+{
+  if (!enabled_)
+  {
+    return;
+  }
+
+  int64_t jitter = (clock_.now() - scheduled).count();
+
+  if (counters_.ticks == 0)
+  {
+    counters_.jitter_min = jitter;
+    counters_.jitter_max = jitter;
+  }
+  else
+  {
+    counters_.jitter_min = std::min(counters_.jitter_min, jitter);
+    counters_.jitter_max = std::max(counters_.jitter_max, jitter);
+  }
+
+  counters_.jitter_sum += jitter;
+  ++counters_.ticks;
+
+  if (!output)
+  {
+    ++counters_.empty_ticks;
+  }
+}
+
+void TickTracer::onState(bool scrolling) noexcept
+{
+  if (!enabled_ || scrolling == scrolling_)
+  {
+    return;
+  }
+
+  std::chrono::microseconds time = clock_.now();
+  report(scrolling_ ? "scroll" : "idle", time);
+
+  scrolling_ = scrolling;
+  begin(time);
+}
+
+void TickTracer::begin(std::chrono::microseconds now) noexcept
+{
+  counters_ = Counters{};
+  counters_.start = now;
+}
+
+void TickTracer::report(const char* what, std::chrono::microseconds now) const
+{
+  const auto& c = counters_;
+  const double seconds = std::chrono::duration<double>(now - c.start).count();
+
+  uint64_t wakeups = 0;
+  for (auto count : c.wakeups)
+  {
+    wakeups += count;
+  }
+
+  SPDLOG_INFO("Trace {} {:.3f}s: {} wakeups ({:.1f}/s; timeout {} mouse {} keyboard {} eintr {})", what, seconds,
+              wakeups, seconds > 0 ? wakeups / seconds : 0.0, c.wakeups[static_cast<size_t>(Wakeup::kTimeout)],
+              c.wakeups[static_cast<size_t>(Wakeup::kMouse)], c.wakeups[static_cast<size_t>(Wakeup::kKeyboard)],
+              c.wakeups[static_cast<size_t>(Wakeup::kInterrupted)]);
+
+  if (c.ticks)
+  {
+    SPDLOG_INFO("Trace {} ticks: {} ({} empty), lateness avg {}us min {}us max {}us", what, c.ticks, c.empty_ticks,
+                c.jitter_sum / static_cast<int64_t>(c.ticks), c.jitter_min, c.jitter_max);
+  }
+}
+
+}  // namespace smooth_scroll
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "clock.h"
+
+namespace smooth_scroll
+{
+
+// Measures how well the main loop keeps to the tick grid and how often it wakes up. Counters are kept per scroll
+// session (first wheel event until the smoother stops) and for the idle time in between, and a summary of each is
+// logged when it ends. While disabled every hook returns after a single branch.
+class TickTracer
+{
+public:
+  enum class Wakeup
+  {
+    kTimeout,
+    kMouse,
+    kKeyboard,
+    kInterrupted,
+    kCount,
+  };
+
+  explicit TickTracer(const Clock& clock) noexcept : clock_{ clock }
+  {
+  }
+
+  void setEnabled(bool enabled) noexcept;
+
+  [[nodiscard]] bool enabled() const noexcept
+  {
+    return enabled_;
+  }
+
+  void onWakeup(Wakeup cause) noexcept;
+
+  // `scheduled` is next_tick_time() before the tick ran, `output` tells whether the tick produced an event.
+  void onTick(std::chrono::microseconds scheduled, bool output) noexcept;
+
+  // Called once per loop iteration with whether the smoother is scrolling; starts and ends sessions.
+  void onState(bool scrolling) noexcept;
+
+private:
+  struct Counters
+  {
+    std::chrono::microseconds start{ 0 };
+    std::array<uint64_t, static_cast<size_t>(Wakeup::kCount)> wakeups{};
+    uint64_t ticks = 0;
+    uint64_t empty_ticks = 0;
+    int64_t jitter_sum = 0;
+    int64_t jitter_max = 0;
+    int64_t jitter_min = 0;
+  };
+
+  void begin(std::chrono::microseconds now) noexcept;
+
+  void report(const char* what, std::chrono::microseconds now) const;
+
+  const Clock& clock_;
+  bool enabled_ = false;
+  bool scrolling_ = false;
+  Counters counters_;
+};
+
+}  // namespace smooth_scroll
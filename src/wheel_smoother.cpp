@@ -3,51 +3,79 @@
 
 #include "wheel_smoother.h"
 
+#include "binary_log.h"
+#include "probes.h"
+
+#include <algorithm>
+#include <cmath>
+
 #include <spdlog/spdlog.h>
 
 namespace smooth_scroll
 {
 
-WheelSmoother::WheelSmoother(const Options& options)
+template <typename Number>
+BasicWheelSmoother<Number>::BasicWheelSmoother(const Options& options)
   : options_{ options }
   , tick_interval_{ static_cast<double>(options.tick_interval_microseconds) / 1.e6 }
-  , inv_tick_interval_{ 1.0 / tick_interval_ }
-  , min_delta_decrease_per_tick_{ options.min_deceleration * tick_interval_ * tick_interval_ }
-  , max_delta_decrease_per_tick_{ options.max_deceleration * tick_interval_ * tick_interval_ }
-  , initial_delta_{ options.initial_speed * tick_interval_ }
-  , alpha_{ std::exp(-options.damping * tick_interval_) }
-  , max_delta_change_lowerbound_{ options.max_speed_change_lowerbound * tick_interval_ }
-  , min_delta_change_upperbound_{ options.min_speed_change_upperbound * tick_interval_ }
+  , inv_tick_interval_{ Policy::ticksPerSecond(options.tick_interval_microseconds) }
+  , min_delta_decrease_per_tick_{ Policy::perTickSquared(Policy::fromDouble(options.min_deceleration),
+                                                         options.tick_interval_microseconds) }
+  , max_delta_decrease_per_tick_{ Policy::perTickSquared(Policy::fromDouble(options.max_deceleration),
+                                                         options.tick_interval_microseconds) }
+  , initial_delta_{ Policy::perTick(Policy::fromDouble(options.initial_speed), options.tick_interval_microseconds) }
+  , alpha_{ Policy::decayPerTick(Policy::fromDouble(options.damping), options.tick_interval_microseconds) }
+  , max_delta_change_lowerbound_{ Policy::perTick(Policy::fromDouble(options.max_speed_change_lowerbound),
+                                                  options.tick_interval_microseconds) }
+  , min_delta_change_upperbound_{ Policy::perTick(Policy::fromDouble(options.min_speed_change_upperbound),
+                                                  options.tick_interval_microseconds) }
+  , speed_factor_{ Policy::fromDouble(options.speed_factor) }
+  , min_speed_change_ratio_{ Policy::fromDouble(options.min_speed_change_ratio) }
+  , max_speed_change_ratio_{ Policy::fromDouble(options.max_speed_change_ratio) }
   , squared_max_mouse_movement_distance_(options.max_mouse_movement_distance * options.max_mouse_movement_distance)
   , mouse_movement_buffer_{ std::chrono::milliseconds(options.mouse_movement_window_milliseconds) }
 {
-  SPDLOG_DEBUG("tick interval {}s alpha {}", tick_interval_, alpha_);
+  SPDLOG_DEBUG("tick interval {}s alpha {}", tick_interval_, Policy::toDouble(alpha_));
 
-  if (options.use_reverse_scroll_braking)
+  if (options_.use_reverse_scroll_braking)
   {
     max_delta_braking_times_.reserve(options.max_reverse_scroll_braking_times);
 
-    double max_delta = initial_delta_;
+    Number max_delta = initial_delta_;
     max_delta_braking_times_.push_back(max_delta);
 
     for (int i = 0; i < options.max_reverse_scroll_braking_times; ++i)
     {
-      max_delta += std::max(max_delta * options.max_speed_change_ratio, min_delta_change_upperbound_);
+      max_delta += std::max(max_delta * max_speed_change_ratio_, min_delta_change_upperbound_);
       max_delta_braking_times_.push_back(max_delta);
     }
   }
 
-  event_intervals_.reserve(16);
+  // One slot per frame, so the worst case is a frame every kMinFrameInterval for the whole window. A faster source
+  // only loses its oldest frames, and the speed is then taken over the part of the window the ring still holds.
+  int window_frames =
+      std::max(static_cast<int>(options.speed_smooth_window_microseconds / kMinFrameInterval.count()), 1);
+  event_intervals_.resize(size_t{ 1 } << (32 - __builtin_clz(static_cast<uint32_t>(window_frames))));
+  event_intervals_mask_ = event_intervals_.size() - 1;
 }
 
-void WheelSmoother::stop() noexcept
+template <typename Number>
+void BasicWheelSmoother<Number>::stop(ProbeStopReason reason) noexcept
 {
+  SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(reason), static_cast<int64_t>(speed()), total_delta_);
+
+  if (delta_ != 0)
+  {
+    endSession(reason);
+  }
+
   delta_ = 0;
   speed_ = 0;
   braking_times_ = 0;
 }
 
-bool WheelSmoother::handleFreeSpinButton(int value) noexcept
+template <typename Number>
+bool BasicWheelSmoother<Number>::handleFreeSpinButton(int value) noexcept
 {
   if (delta_ != 0 && value == 1)
   {
@@ -67,11 +95,15 @@ bool WheelSmoother::handleFreeSpinButton(int value) noexcept
   return false;
 }
 
-bool WheelSmoother::handleDragViewButton(int value) noexcept
+template <typename Number>
+bool BasicWheelSmoother<Number>::handleDragViewButton(int value) noexcept
 {
   if (delta_ != 0 && value == 1)
   {
     drag_view_ = true;
+    SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(ProbeStopReason::kDragView), static_cast<int64_t>(speed()),
+                         total_delta_);
+    endSession(ProbeStopReason::kDragView);
     delta_ = 0;
     speed_ = 0;
     return true;
@@ -89,8 +121,13 @@ bool WheelSmoother::handleDragViewButton(int value) noexcept
   return false;
 }
 
-std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeval& time, bool positive, bool horizontal)
+template <typename Number>
+std::optional<struct input_event> BasicWheelSmoother<Number>::handleEvent(const struct timeval& time,
+                                                                                    bool positive, bool horizontal,
+                                                                                    int notches)
 {
+  SMOOTH_SCROLL_PROBE3(wheel_event, time.tv_sec * 1'000'000 + time.tv_usec, positive, horizontal);
+
   if (drag_view_)
   {
     return std::nullopt;
@@ -98,6 +135,12 @@ std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeva
 
   if (horizontal_ != horizontal)
   {
+    if (delta_ != 0)
+    {
+      SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(ProbeStopReason::kAxisChange), static_cast<int64_t>(speed()),
+                           total_delta_);
+      endSession(ProbeStopReason::kAxisChange);
+    }
     delta_ = 0;
     speed_ = 0;
     braking_times_ = 0;
@@ -116,8 +159,11 @@ std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeva
     {
       if (delta_ != 0)
       {
-        SPDLOG_DEBUG("reverse scroll stop");
-        event_intervals_.clear();
+        logEvent(LogEvent::kReverseScrollStop);
+        SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(ProbeStopReason::kReverseScroll), static_cast<int64_t>(speed()),
+                             total_delta_);
+        endSession(ProbeStopReason::kReverseScroll);
+        num_event_intervals_ = 0;
         last_event_time_ = event_time;
         last_brake_stop_time_ = event_time;
         delta_ = 0;
@@ -134,30 +180,32 @@ std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeva
                 last_brake_stop_time_ + std::chrono::microseconds{ options_.max_reverse_scroll_braking_microseconds } &&
             braking_times_ < options_.max_reverse_scroll_braking_times)
         {
-          SPDLOG_DEBUG("braking dejitter");
-          event_intervals_.push_back(event_time - last_event_time_);
+          logEvent(LogEvent::kBrakingDejitter);
+          pushEventInterval(event_time - last_event_time_);
           last_event_time_ = event_time;
           ++braking_times_;
           return std::nullopt;
         }
 
-        double speed = smoothSpeed(event_time - last_event_time_);
+        Number speed = smoothSpeed(event_time - last_event_time_, notches);
 
         last_event_time_ = event_time;
         next_tick_time_ = event_time + std::chrono::microseconds{ options_.tick_interval_microseconds };
 
         positive_ = positive;
 
-        delta_ = std::clamp(speed * tick_interval_, initial_delta_, max_delta_braking_times_[braking_times_]);
+        delta_ = std::clamp(Policy::perTick(speed, options_.tick_interval_microseconds), initial_delta_,
+                            max_delta_braking_times_[braking_times_]);
         speed_ = delta_ * inv_tick_interval_;
         braking_times_ = 0;
 
-        SPDLOG_DEBUG("initial speed {:.2f}", speed_);
+        logEvent(LogEvent::kInitialSpeed, Policy::toDouble(speed_));
 
-        int round_delta = std::round(delta_);
+        int round_delta = Policy::round(delta_);
         deviation_ = delta_ - round_delta;
 
         total_delta_ = round_delta;
+        beginSession(event_time, notches);
 
         struct input_event ev;
         ev.time = time;
@@ -172,7 +220,7 @@ std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeva
 
   if (delta_ == 0)
   {
-    event_intervals_.clear();
+    num_event_intervals_ = 0;
     last_event_time_ = event_time;
     next_tick_time_ = event_time + std::chrono::microseconds{ options_.tick_interval_microseconds };
 
@@ -181,12 +229,13 @@ std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeva
     delta_ = initial_delta_;
     speed_ = delta_ * inv_tick_interval_;
 
-    SPDLOG_DEBUG("initial speed {:.2f}", speed_);
+    logEvent(LogEvent::kInitialSpeed, Policy::toDouble(speed_));
 
-    int round_delta = std::round(delta_);
+    int round_delta = Policy::round(delta_);
     deviation_ = delta_ - round_delta;
 
     total_delta_ = round_delta;
+    beginSession(event_time, notches);
 
     struct input_event ev;
     ev.time = time;
@@ -197,22 +246,27 @@ std::optional<struct input_event> WheelSmoother::handleEvent(const struct timeva
     return ev;
   }
 
-  const double speed = smoothSpeed(event_time - last_event_time_);
-  const double min_delta_change = std::min(delta_ * options_.min_speed_change_ratio, max_delta_change_lowerbound_);
-  const double max_delta_change = std::max(delta_ * options_.max_speed_change_ratio, min_delta_change_upperbound_);
+  const Number speed = smoothSpeed(event_time - last_event_time_, notches);
+  const Number min_delta_change = std::min(delta_ * min_speed_change_ratio_, max_delta_change_lowerbound_);
+  const Number max_delta_change = std::max(delta_ * max_speed_change_ratio_, min_delta_change_upperbound_);
 
-  double delta = std::clamp(speed * tick_interval_, delta_ + min_delta_change, delta_ + max_delta_change);
+  Number delta = std::clamp(Policy::perTick(speed, options_.tick_interval_microseconds), delta_ + min_delta_change,
+                            delta_ + max_delta_change);
 
   last_event_time_ = event_time;
   delta_ = delta < initial_delta_ ? initial_delta_ : delta;
   speed_ = delta_ * inv_tick_interval_;
 
-  SPDLOG_DEBUG("set speed: actual {:.2f} target {:.2f}", speed_, speed);
+  logEvent(LogEvent::kSetSpeed, Policy::toDouble(speed_), Policy::toDouble(speed));
+
+  session_.notches += notches;
+  session_.peak_speed = std::max(session_.peak_speed, this->speed());
 
   return std::nullopt;
 }
 
-std::optional<struct input_event> WheelSmoother::tick() noexcept
+template <typename Number>
+std::optional<struct input_event> BasicWheelSmoother<Number>::tick() noexcept
 {
   if (delta_ == 0)
   {
@@ -221,8 +275,8 @@ std::optional<struct input_event> WheelSmoother::tick() noexcept
 
   if (!free_spin_)
   {
-    double max_delta = delta_ - min_delta_decrease_per_tick_;
-    double min_delta = delta_ - max_delta_decrease_per_tick_;
+    Number max_delta = delta_ - min_delta_decrease_per_tick_;
+    Number min_delta = delta_ - max_delta_decrease_per_tick_;
 
     delta_ *= alpha_;
 
@@ -238,7 +292,9 @@ std::optional<struct input_event> WheelSmoother::tick() noexcept
 
     if (delta_ < 0)
     {
-      SPDLOG_DEBUG("damping stop, total {}", total_delta_);
+      logEvent(LogEvent::kDampingStop, total_delta_);
+      SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(ProbeStopReason::kDamping), 0, total_delta_);
+      endSession(ProbeStopReason::kDamping);
 
       delta_ = 0;
       speed_ = 0;
@@ -246,22 +302,25 @@ std::optional<struct input_event> WheelSmoother::tick() noexcept
     }
 
     speed_ = delta_ * inv_tick_interval_;
-    SPDLOG_TRACE("tick speed {:.2f} deceleration {:.2f}", speed_,
-                 (max_delta + min_delta_decrease_per_tick_ - delta_) / (tick_interval_ * tick_interval_));
+    logEvent(LogEvent::kTickSpeed, Policy::toDouble(speed_),
+             Policy::toDouble(max_delta + min_delta_decrease_per_tick_ - delta_) / (tick_interval_ * tick_interval_));
   }
 
   std::chrono::microseconds current_tick_time = next_tick_time_;
   next_tick_time_ += std::chrono::microseconds{ options_.tick_interval_microseconds };
 
-  int round_delta = std::round(delta_ + deviation_);
+  int round_delta = Policy::round(delta_ + deviation_);
   deviation_ = delta_ + deviation_ - round_delta;
 
+  SMOOTH_SCROLL_PROBE3(tick, current_tick_time.count(), round_delta, static_cast<int64_t>(speed()));
+
   if (round_delta == 0)
   {
     return std::nullopt;
   }
 
   total_delta_ += round_delta;
+  session_.end_time = current_tick_time;
 
   struct input_event ev;
   ev.time.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(current_tick_time).count();
@@ -273,38 +332,84 @@ std::optional<struct input_event> WheelSmoother::tick() noexcept
   return ev;
 }
 
-std::optional<struct timeval> WheelSmoother::timeout() const noexcept
+template <typename Number>
+std::optional<struct input_event> BasicWheelSmoother<Number>::tick(int ticks) noexcept
 {
+  if (ticks <= 1)
+  {
+    return tick();
+  }
+
   if (delta_ == 0)
   {
     return std::nullopt;
   }
 
-  std::chrono::microseconds now =
-      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+  bool stopped = false;
+  Number sum = free_spin_ ? ticks * delta_ : decelerate(ticks, stopped);
+
+  std::chrono::microseconds current_tick_time =
+      next_tick_time_ + std::chrono::microseconds{ options_.tick_interval_microseconds } * (ticks - 1);
+  next_tick_time_ = current_tick_time + std::chrono::microseconds{ options_.tick_interval_microseconds };
+
+  if (stopped)
+  {
+    logEvent(LogEvent::kDampingStop, total_delta_);
+    SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(ProbeStopReason::kDamping), 0, total_delta_);
+
+    delta_ = 0;
+    speed_ = 0;
+  }
+  else
+  {
+    speed_ = delta_ * inv_tick_interval_;
+  }
+
+  int round_delta = Policy::round(sum + deviation_);
+  deviation_ = sum + deviation_ - round_delta;
+
+  SMOOTH_SCROLL_PROBE3(tick, current_tick_time.count(), round_delta, static_cast<int64_t>(speed()));
 
-  if (now >= next_tick_time_)
+  if (round_delta != 0)
   {
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 0;
-    return timeout;
+    total_delta_ += round_delta;
+    session_.end_time = current_tick_time;
   }
 
-  struct timeval timeout;
-  timeout.tv_sec = 0;
-  timeout.tv_usec = (next_tick_time_ - now).count();
+  // The catch-up output still belongs to the session that damping ended.
+  if (stopped)
+  {
+    endSession(ProbeStopReason::kDamping);
+  }
 
-  while (timeout.tv_usec >= 1'000'000)
+  if (round_delta == 0)
   {
-    timeout.tv_sec += 1;
-    timeout.tv_usec -= 1'000'000;
+    return std::nullopt;
   }
 
-  return timeout;
+  struct input_event ev;
+  ev.time.tv_sec = std::chrono::duration_cast<std::chrono::seconds>(current_tick_time).count();
+  ev.time.tv_usec = (current_tick_time - std::chrono::seconds{ ev.time.tv_sec }).count();
+  ev.type = EV_REL;
+  ev.code = horizontal_ ? REL_HWHEEL_HI_RES : REL_WHEEL_HI_RES;
+  ev.value = positive_ ? round_delta : -round_delta;
+
+  return ev;
 }
 
-std::optional<std::chrono::microseconds> WheelSmoother::next_tick_time() const noexcept
+template <typename Number>
+int BasicWheelSmoother<Number>::dueTicks(std::chrono::microseconds now) const noexcept
+{
+  if (delta_ == 0 || now < next_tick_time_)
+  {
+    return 0;
+  }
+
+  return (now - next_tick_time_) / std::chrono::microseconds{ options_.tick_interval_microseconds } + 1;
+}
+
+template <typename Number>
+std::optional<std::chrono::microseconds> BasicWheelSmoother<Number>::next_tick_time() const noexcept
 {
   if (delta_ == 0)
   {
@@ -314,7 +419,8 @@ std::optional<std::chrono::microseconds> WheelSmoother::next_tick_time() const n
   return next_tick_time_;
 }
 
-void WheelSmoother::handleRelXEvent(struct input_event& ev) noexcept
+template <typename Number>
+void BasicWheelSmoother<Number>::handleRelXEvent(struct input_event& ev) noexcept
 {
   if (drag_view_)
   {
@@ -326,7 +432,8 @@ void WheelSmoother::handleRelXEvent(struct input_event& ev) noexcept
   rel_x_ = ev.value;
 }
 
-void WheelSmoother::handleRelYEvent(struct input_event& ev) noexcept
+template <typename Number>
+void BasicWheelSmoother<Number>::handleRelYEvent(struct input_event& ev) noexcept
 {
   if (drag_view_)
   {
@@ -338,8 +445,11 @@ void WheelSmoother::handleRelYEvent(struct input_event& ev) noexcept
   rel_y_ = ev.value;
 }
 
-bool WheelSmoother::handleReportEvent(const struct timeval& time) noexcept
+template <typename Number>
+bool BasicWheelSmoother<Number>::handleReportEvent(const struct timeval& time) noexcept
 {
+  SMOOTH_SCROLL_PROBE3(report, time.tv_sec * 1'000'000 + time.tv_usec, rel_x_, rel_y_);
+
   if (rel_x_ == 0 && rel_y_ == 0)
   {
     return false;
@@ -358,7 +468,10 @@ bool WheelSmoother::handleReportEvent(const struct timeval& time) noexcept
       int squared_distance = result.x * result.x + result.y * result.y;
       if (squared_distance > squared_max_mouse_movement_distance_)
       {
-        SPDLOG_DEBUG("movement stop");
+        logEvent(LogEvent::kMovementStop);
+        SMOOTH_SCROLL_PROBE3(stop, static_cast<int>(ProbeStopReason::kMouseMovement), static_cast<int64_t>(speed()),
+                             total_delta_);
+        endSession(ProbeStopReason::kMouseMovement);
         delta_ = 0;
         speed_ = 0;
 
@@ -374,36 +487,148 @@ bool WheelSmoother::handleReportEvent(const struct timeval& time) noexcept
   return false;
 }
 
-double WheelSmoother::smoothSpeed(const std::chrono::microseconds event_interval)
+template <typename Number>
+Number BasicWheelSmoother<Number>::decelerate(int ticks, bool& stopped) noexcept
+{
+  // Each tick sets delta = clamp(alpha * delta, delta - b, delta - a) with a and b the minimum and maximum decrease.
+  // As delta only falls, that is a run of d - b steps while delta * (1 - alpha) > b, then a geometric run while
+  // delta * (1 - alpha) >= a, then d - a steps until it goes negative. Each run has a closed-form sum.
+  const Number a = min_delta_decrease_per_tick_;
+  const Number b = max_delta_decrease_per_tick_;
+  const Number k = 1 - alpha_;
+
+  Number delta = delta_;
+  Number sum = 0;
+
+  if constexpr (Policy::kClosedForm)
+  {
+    if (a > 0 && a <= b && k > 0 && k < 1)
+    {
+      if (delta * k > b)
+      {
+        int64_t n = std::min<int64_t>(ticks, std::ceil((delta - b / k) / b));
+        sum += n * delta - b * n * (n + 1) / 2;
+        delta -= n * b;
+        ticks -= n;
+      }
+
+      if (ticks > 0 && delta * k >= a)
+      {
+        int64_t n = std::min<int64_t>(ticks, std::floor(std::log(a / (delta * k)) / std::log(alpha_)) + 1);
+        Number alpha_n = std::pow(alpha_, n);
+        sum += delta * alpha_ * (1 - alpha_n) / k;
+        delta *= alpha_n;
+        ticks -= n;
+      }
+
+      if (ticks > 0)
+      {
+        // Ticks that leave delta non-negative.
+        int64_t n = std::floor(delta / a);
+        if (n < ticks)
+        {
+          stopped = true;
+          return sum + n * delta - a * n * (n + 1) / 2;
+        }
+
+        sum += ticks * delta - a * static_cast<int64_t>(ticks) * (ticks + 1) / 2;
+        delta -= ticks * a;
+      }
+
+      delta_ = delta;
+      return sum;
+    }
+  }
+
+  // Degenerate settings, or a number type without exact log() and pow(): step tick by tick.
+  for (; ticks > 0; --ticks)
+  {
+    delta = std::max(std::min(delta * alpha_, delta - a), delta - b);
+    if (delta < 0)
+    {
+      stopped = true;
+      return sum;
+    }
+    sum += delta;
+  }
+
+  delta_ = delta;
+  return sum;
+}
+
+template <typename Number>
+Number BasicWheelSmoother<Number>::smoothSpeed(std::chrono::microseconds event_interval, int notches)
 {
   const std::chrono::microseconds speed_smooth_window{ options_.speed_smooth_window_microseconds };
 
-  double num_event_intervals = 1;
+  if (notches > 1 && event_interval <= speed_smooth_window)
+  {
+    auto notch_interval = event_interval / notches;
+    pushEventInterval(notch_interval, notches - 1);
+    event_interval -= notch_interval * (notches - 1);
+  }
+
+  Number num_event_intervals = 1;
   std::chrono::microseconds duration = event_interval;
 
   if (event_interval > speed_smooth_window)
   {
-    event_intervals_.clear();
+    num_event_intervals_ = 0;
   }
   else
   {
-    for (auto iter = event_intervals_.rbegin(); iter != event_intervals_.rend(); ++iter)
+    for (size_t i = 1; i <= num_event_intervals_; ++i)
     {
-      if (*iter + duration > speed_smooth_window)
+      const auto& [interval, count] = event_intervals_[(event_intervals_end_ - i) & event_intervals_mask_];
+      if (interval * count + duration > speed_smooth_window)
       {
-        num_event_intervals += std::chrono::duration<double>(speed_smooth_window - duration).count() /
-                               std::chrono::duration<double>(*iter).count();
+        // Whole intervals that still fit, then a fraction of the next.
+        auto whole = (speed_smooth_window - duration) / interval;
+        duration += interval * whole;
+        num_event_intervals += static_cast<Number>(whole);
+        num_event_intervals += Policy::fraction(speed_smooth_window - duration, interval);
         duration = speed_smooth_window;
         break;
       }
 
-      duration += *iter;
-      num_event_intervals += 1;
+      duration += interval * count;
+      num_event_intervals += count;
     }
-    event_intervals_.push_back(event_interval);
+    pushEventInterval(event_interval);
   }
 
-  return options_.speed_factor * num_event_intervals / std::chrono::duration<double>(duration).count();
+  return Policy::rate(speed_factor_, num_event_intervals, duration);
 }
 
+template <typename Number>
+void BasicWheelSmoother<Number>::pushEventInterval(std::chrono::microseconds event_interval,
+                                                             int count) noexcept
+{
+  event_intervals_[event_intervals_end_] = { event_interval, count };
+  event_intervals_end_ = (event_intervals_end_ + 1) & event_intervals_mask_;
+  num_event_intervals_ = std::min(num_event_intervals_ + 1, event_intervals_.size());
+}
+
+template <typename Number>
+void BasicWheelSmoother<Number>::beginSession(std::chrono::microseconds time, int notches) noexcept
+{
+  session_ = ScrollSession{};
+  session_.start_time = time;
+  session_.end_time = time;
+  session_.notches = notches;
+  session_.peak_speed = speed();
+  session_.horizontal = horizontal_;
+}
+
+template <typename Number>
+void BasicWheelSmoother<Number>::endSession(ProbeStopReason reason) noexcept
+{
+  session_.distance = total_delta_;
+  session_.stop_reason = reason;
+  ended_session_ = session_;
+}
+
+template class BasicWheelSmoother<double>;
+template class BasicWheelSmoother<Fixed>;
+
 }  // namespace smooth_scroll
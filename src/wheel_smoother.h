@@ -5,64 +5,98 @@
 
 #include <chrono>
 #include <optional>
+#include <utility>
 #include <vector>
 
 #include <linux/input.h>
 
 #include "mouse_movement_buffer.h"
+#include "numeric.h"
+#include "probes.h"
 
 namespace smooth_scroll
 {
 
-class WheelSmoother
+struct WheelSmootherOptions
+{
+  int tick_interval_microseconds = 2000;
+
+  double min_deceleration = 1420;
+  double max_deceleration = 6000;
+  double initial_speed = 600;
+  double speed_factor = 40;
+  int speed_smooth_window_microseconds = 200000;
+  double max_speed_change_lowerbound = 512;
+  double min_speed_change_upperbound = 1024;
+  double min_speed_change_ratio = 0.0625;
+  double max_speed_change_ratio = 1;
+  double damping = 3.1;
+
+  bool use_reverse_scroll_braking = true;
+  int max_reverse_scroll_braking_microseconds = 100000;
+  int max_reverse_scroll_braking_times = 3;
+
+  bool use_mouse_movement_braking = true;
+  int max_mouse_movement_distance = 30;
+  int mouse_movement_window_milliseconds = 20;
+  int mouse_movement_delay_microseconds = 100000;
+
+  int drag_view_speed = 3;
+};
+
+// One scroll, from the notch that starts it to whatever stops it.
+struct ScrollSession
+{
+  std::chrono::microseconds start_time{ 0 };
+  // Time of the last scroll output.
+  std::chrono::microseconds end_time{ 0 };
+  int notches = 0;
+  // Hi-res units per second.
+  double peak_speed = 0;
+  // Hi-res units scrolled.
+  int distance = 0;
+  ProbeStopReason stop_reason = ProbeStopReason::kExternal;
+  bool horizontal = false;
+};
+
+// The smoothing state machine. `Number` is the type of its arithmetic, from the constants derived from the options
+// through speed estimation to the ticks: double, or Fixed for integer math that gives the same output on every
+// platform.
+template <typename Number>
+class BasicWheelSmoother
 {
 public:
-  struct Options
-  {
-    int tick_interval_microseconds = 2000;
-
-    double min_deceleration = 1420;
-    double max_deceleration = 6000;
-    double initial_speed = 600;
-    double speed_factor = 40;
-    int speed_smooth_window_microseconds = 200000;
-    double max_speed_change_lowerbound = 512;
-    double min_speed_change_upperbound = 1024;
-    double min_speed_change_ratio = 0.0625;
-    double max_speed_change_ratio = 1;
-    double damping = 3.1;
-
-    bool use_reverse_scroll_braking = true;
-    int max_reverse_scroll_braking_microseconds = 100000;
-    int max_reverse_scroll_braking_times = 3;
-
-    bool use_mouse_movement_braking = true;
-    int max_mouse_movement_distance = 30;
-    int mouse_movement_window_milliseconds = 20;
-    int mouse_movement_delay_microseconds = 100000;
-
-    int drag_view_speed = 3;
-  };
+  using Options = WheelSmootherOptions;
+  using Policy = NumericPolicy<Number>;
 
-  explicit WheelSmoother(const Options& options);
+  explicit BasicWheelSmoother(const Options& options);
 
-  WheelSmoother(const WheelSmoother&) = delete;
-  WheelSmoother& operator=(const WheelSmoother&) = delete;
+  BasicWheelSmoother(const BasicWheelSmoother&) = delete;
+  BasicWheelSmoother& operator=(const BasicWheelSmoother&) = delete;
 
-  WheelSmoother(WheelSmoother&&) = delete;
-  WheelSmoother& operator=(WheelSmoother&&) = delete;
+  BasicWheelSmoother(BasicWheelSmoother&&) = delete;
+  BasicWheelSmoother& operator=(BasicWheelSmoother&&) = delete;
 
-  void stop() noexcept;
+  void stop(ProbeStopReason reason = ProbeStopReason::kExternal) noexcept;
 
   bool handleFreeSpinButton(int value) noexcept;
 
   bool handleDragViewButton(int value) noexcept;
 
-  std::optional<struct input_event> handleEvent(const struct timeval& time, bool positive, bool horizontal);
+  // Handles the wheel events of one frame on one axis: `notches` notches in the same direction, reported together
+  // at `time`. They count as that many notches evenly spaced since the previous report, so a fast spin that the
+  // device batches updates the speed estimate once with the right rate. Returns at most one event.
+  std::optional<struct input_event> handleEvent(const struct timeval& time, bool positive, bool horizontal,
+                                                int notches = 1);
 
   std::optional<struct input_event> tick() noexcept;
 
-  std::optional<struct timeval> timeout() const noexcept;
+  // Runs `ticks` ticks at once and returns their summed output as a single event, timed at the last of them. The
+  // speed is advanced in closed form, so a loop that woke up late catches up in one step. tick(1) is tick().
+  std::optional<struct input_event> tick(int ticks) noexcept;
+
+  // Number of ticks scheduled at or before `now`.
+  [[nodiscard]] int dueTicks(std::chrono::microseconds now) const noexcept;
 
   std::optional<std::chrono::microseconds> next_tick_time() const noexcept;
 
@@ -84,7 +118,7 @@ public:
 
   [[nodiscard]] double speed() const noexcept
   {
-    return speed_;
+    return Policy::toDouble(speed_);
   }
 
   [[nodiscard]] bool free_spin() const noexcept
@@ -97,38 +131,81 @@ public:
     return drag_view_;
   }
 
+  // The last scroll that ended since the previous call, if any.
+  [[nodiscard]] std::optional<ScrollSession> takeEndedSession() noexcept
+  {
+    return std::exchange(ended_session_, std::nullopt);
+  }
+
 private:
-  double smoothSpeed(const std::chrono::microseconds event_interval);
+  // Hi-res units per second over the smoothing window.
+  Number smoothSpeed(std::chrono::microseconds event_interval, int notches);
+
+  void pushEventInterval(std::chrono::microseconds event_interval, int count = 1) noexcept;
+
+  // Advances delta_ by up to `ticks` ticks of deceleration and returns the sum of the deltas of the ticks that ran.
+  // Sets `stopped` if the speed ran out on the way, leaving delta_ for the caller to clear.
+  Number decelerate(int ticks, bool& stopped) noexcept;
+
+  void beginSession(std::chrono::microseconds time, int notches) noexcept;
+
+  void endSession(ProbeStopReason reason) noexcept;
 
   Options options_;
 
   double tick_interval_;
-  double inv_tick_interval_;
-  double min_delta_decrease_per_tick_;
-  double max_delta_decrease_per_tick_;
-  double initial_delta_;
-  double alpha_;
-  double max_delta_change_lowerbound_;
-  double min_delta_change_upperbound_;
+  Number inv_tick_interval_;
+  Number min_delta_decrease_per_tick_;
+  Number max_delta_decrease_per_tick_;
+  Number initial_delta_;
+  Number alpha_;
+  Number max_delta_change_lowerbound_;
+  Number min_delta_change_upperbound_;
+  Number speed_factor_;
+  Number min_speed_change_ratio_;
+  Number max_speed_change_ratio_;
   int squared_max_mouse_movement_distance_;
   MouseMovementBuffer mouse_movement_buffer_;
-  std::vector<double> max_delta_braking_times_;
+  std::vector<Number> max_delta_braking_times_;
 
-  std::vector<std::chrono::microseconds> event_intervals_;
+  // `count` consecutive intervals of the same length: the notches of one frame are spread evenly over its interval, so
+  // a frame takes one slot however many notches it carries.
+  struct EventInterval
+  {
+    std::chrono::microseconds interval;
+    int count;
+  };
+
+  // No device reports frames faster than USB's 8 kHz polling.
+  static constexpr std::chrono::microseconds kMinFrameInterval{ 125 };
+
+  // Ring of the latest event intervals, sized once so that it holds every frame inside the smoothing window.
+  std::vector<EventInterval> event_intervals_;
+  size_t event_intervals_mask_;
+  size_t event_intervals_end_ = 0;
+  size_t num_event_intervals_ = 0;
   std::chrono::microseconds last_event_time_{ 0 };
   std::chrono::microseconds next_tick_time_{ 0 };
   std::chrono::microseconds last_brake_stop_time_{ 0 };
   bool positive_ = false;
   bool horizontal_ = false;
-  double delta_ = 0;
-  double speed_ = 0;
-  double deviation_ = 0;
+  Number delta_ = 0;
+  Number speed_ = 0;
+  Number deviation_ = 0;
   int total_delta_ = 0;
   int braking_times_ = 0;
   int rel_x_ = 0;
   int rel_y_ = 0;
   bool free_spin_ = false;
   bool drag_view_ = false;
+  ScrollSession session_;
+  std::optional<ScrollSession> ended_session_;
 };
 
+using WheelSmoother = BasicWheelSmoother<double>;
+using FixedWheelSmoother = BasicWheelSmoother<Fixed>;
+
+extern template class BasicWheelSmoother<double>;
+extern template class BasicWheelSmoother<Fixed>;
+
 }  // namespace smooth_scroll
@@ -0,0 +1,339 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "batch_smoother.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace smooth_scroll
+{
+
+namespace
+{
+
+// The per-tick update of WheelSmoother::tick() for a whole batch. Every branch is expressed as a select or a 0/1
+// multiplier so that the loop has no control flow and compiles to SIMD; std::round is spelled out with an int32
+// truncation, which has a vector form on every x86-64 target.
+void tickRound(size_t n, double round, double* __restrict delta, double* __restrict deviation,
+               double* __restrict num_ticks, double* __restrict stop_tick, double* __restrict distance,
+               double* __restrict overshoot, double* __restrict output_events, const double* __restrict alpha,
+               const double* __restrict min_decrease, const double* __restrict max_decrease,
+               const double* __restrict against_input) noexcept
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double d0 = delta[i];
+    double d = std::min(d0 * alpha[i], d0 - min_decrease[i]);
+    d = std::max(d, d0 - max_decrease[i]);
+
+    const double active = round < num_ticks[i] ? 1.0 : 0.0;
+    const double stopped = d < 0 ? active : 0.0;
+    const double output = active - stopped;
+
+    const double total = d + deviation[i];
+    const double truncated = static_cast<double>(static_cast<int>(total));
+    const double fraction = total - truncated;
+    const double round_delta = truncated + (fraction >= 0.5 ? 1.0 : 0.0) - (fraction <= -0.5 ? 1.0 : 0.0);
+
+    delta[i] = output != 0 ? d : (stopped != 0 ? 0.0 : d0);
+    deviation[i] = output != 0 ? total - round_delta : deviation[i];
+    distance[i] += output * round_delta;
+    overshoot[i] += output * round_delta * against_input[i];
+    output_events[i] += round_delta != 0 ? output : 0.0;
+    stop_tick[i] += stopped * (round - stop_tick[i]);
+    num_ticks[i] -= stopped * num_ticks[i];
+  }
+}
+
+}  // namespace
+
+BatchWheelSmoother::BatchWheelSmoother(const std::vector<WheelSmoother::Options>& options, size_t begin, size_t end)
+  : tick_interval_us_{ options[begin].tick_interval_microseconds }
+  , tick_interval_{ static_cast<double>(tick_interval_us_) / 1.e6 }
+{
+  const size_t n = end - begin;
+
+  inv_tick_interval_.resize(n);
+  min_delta_decrease_per_tick_.resize(n);
+  max_delta_decrease_per_tick_.resize(n);
+  initial_delta_.resize(n);
+  alpha_.resize(n);
+  max_delta_change_lowerbound_.resize(n);
+  min_delta_change_upperbound_.resize(n);
+  min_speed_change_ratio_.resize(n);
+  max_speed_change_ratio_.resize(n);
+  speed_factor_.resize(n);
+  speed_smooth_window_us_.resize(n);
+  use_reverse_scroll_braking_.resize(n);
+  max_reverse_scroll_braking_us_.resize(n);
+  max_reverse_scroll_braking_times_.resize(n);
+  braking_table_offset_.resize(n);
+
+  history_begin_.assign(n, 0);
+  next_tick_time_.assign(n, 0);
+  num_ticks_.assign(n, 0);
+  stop_tick_.assign(n, -1);
+  last_brake_stop_time_.assign(n, 0);
+  stop_time_.assign(n, 0);
+  positive_.assign(n, false);
+  horizontal_.assign(n, false);
+  delta_.assign(n, 0);
+  speed_.assign(n, 0);
+  deviation_.assign(n, 0);
+  braking_times_.assign(n, 0);
+
+  distance_.assign(n, 0);
+  overshoot_.assign(n, 0);
+  against_input_.assign(n, 0);
+  peak_speed_.assign(n, 0);
+  output_events_.assign(n, 0);
+
+  // Derived constants are computed exactly as WheelSmoother does, so both produce identical output as long as
+  // WheelSmoother is ticked one tick at a time, as the event loop does while it keeps up. tick(n) catches up in closed
+  // form and rounds once for all n ticks. `ss-sweep --check` compares the two.
+  for (size_t i = 0; i < n; ++i)
+  {
+    const WheelSmoother::Options& o = options[begin + i];
+    assert(o.tick_interval_microseconds == tick_interval_us_);
+
+    inv_tick_interval_[i] = 1.0 / tick_interval_;
+    min_delta_decrease_per_tick_[i] = o.min_deceleration * tick_interval_ * tick_interval_;
+    max_delta_decrease_per_tick_[i] = o.max_deceleration * tick_interval_ * tick_interval_;
+    initial_delta_[i] = o.initial_speed * tick_interval_;
+    alpha_[i] = std::exp(-o.damping * tick_interval_);
+    max_delta_change_lowerbound_[i] = o.max_speed_change_lowerbound * tick_interval_;
+    min_delta_change_upperbound_[i] = o.min_speed_change_upperbound * tick_interval_;
+    min_speed_change_ratio_[i] = o.min_speed_change_ratio;
+    max_speed_change_ratio_[i] = o.max_speed_change_ratio;
+    speed_factor_[i] = o.speed_factor;
+    speed_smooth_window_us_[i] = o.speed_smooth_window_microseconds;
+    use_reverse_scroll_braking_[i] = o.use_reverse_scroll_braking;
+    max_reverse_scroll_braking_us_[i] = o.max_reverse_scroll_braking_microseconds;
+    max_reverse_scroll_braking_times_[i] = o.max_reverse_scroll_braking_times;
+    braking_table_offset_[i] = max_delta_braking_times_.size();
+
+    if (o.use_reverse_scroll_braking)
+    {
+      double max_delta = initial_delta_[i];
+      max_delta_braking_times_.push_back(max_delta);
+
+      for (int j = 0; j < o.max_reverse_scroll_braking_times; ++j)
+      {
+        max_delta += std::max(max_delta * o.max_speed_change_ratio, min_delta_change_upperbound_[i]);
+        max_delta_braking_times_.push_back(max_delta);
+      }
+    }
+  }
+}
+
+double BatchWheelSmoother::smoothSpeed(size_t i, size_t event_index) const noexcept
+{
+  const std::chrono::microseconds speed_smooth_window{ speed_smooth_window_us_[i] };
+  const std::chrono::microseconds event_interval = event_intervals_[event_index];
+
+  double num_event_intervals = 1;
+  std::chrono::microseconds duration = event_interval;
+
+  if (event_interval <= speed_smooth_window)
+  {
+    for (size_t j = event_index; j-- > history_begin_[i];)
+    {
+      if (event_intervals_[j] + duration > speed_smooth_window)
+      {
+        num_event_intervals += std::chrono::duration<double>(speed_smooth_window - duration).count() /
+                               std::chrono::duration<double>(event_intervals_[j]).count();
+        duration = speed_smooth_window;
+        break;
+      }
+
+      duration += event_intervals_[j];
+      num_event_intervals += 1;
+    }
+  }
+
+  return speed_factor_[i] * num_event_intervals / std::chrono::duration<double>(duration).count();
+}
+
+void BatchWheelSmoother::emit(size_t i, double delta) noexcept
+{
+  int round_delta = std::round(delta);
+  deviation_[i] = delta - round_delta;
+
+  distance_[i] += round_delta;
+  output_events_[i] += round_delta != 0 ? 1 : 0;
+  peak_speed_[i] = std::max(peak_speed_[i], speed_[i]);
+}
+
+void BatchWheelSmoother::handleEvent(std::chrono::microseconds time, bool positive, bool horizontal)
+{
+  const size_t k = event_intervals_.size();
+  const int64_t t = time.count();
+
+  event_intervals_.push_back(time - last_event_time_);
+  last_event_time_ = time;
+
+  // Mirrors WheelSmoother::handleEvent. Clearing the interval history is expressed by moving `history_begin_`
+  // past the current event; keeping the current interval leaves it untouched.
+  for (size_t i = 0; i < size(); ++i)
+  {
+    if (horizontal_[i] != horizontal && delta_[i] != 0)
+    {
+      delta_[i] = 0;
+      speed_[i] = 0;
+      stop_time_[i] = t;
+    }
+
+    if (horizontal_[i] != horizontal)
+    {
+      braking_times_[i] = 0;
+    }
+
+    if (use_reverse_scroll_braking_[i])
+    {
+      if (positive == static_cast<bool>(positive_[i]))
+      {
+        braking_times_[i] = 0;
+      }
+      else
+      {
+        if (delta_[i] != 0)
+        {
+          history_begin_[i] = k + 1;
+          last_brake_stop_time_[i] = t;
+          stop_time_[i] = t;
+          delta_[i] = 0;
+          speed_[i] = 0;
+          braking_times_[i] = 1;
+          continue;
+        }
+
+        if (braking_times_[i])
+        {
+          if (t < last_brake_stop_time_[i] + max_reverse_scroll_braking_us_[i] &&
+              braking_times_[i] < max_reverse_scroll_braking_times_[i])
+          {
+            ++braking_times_[i];
+            continue;
+          }
+
+          double speed = smoothSpeed(i, k);
+          if (event_intervals_[k].count() > speed_smooth_window_us_[i])
+          {
+            history_begin_[i] = k + 1;
+          }
+
+          next_tick_time_[i] = t + tick_interval_us_;
+          positive_[i] = positive;
+
+          delta_[i] = std::clamp(speed * tick_interval_, initial_delta_[i],
+                                 max_delta_braking_times_[braking_table_offset_[i] + braking_times_[i]]);
+          speed_[i] = delta_[i] * inv_tick_interval_[i];
+          braking_times_[i] = 0;
+
+          emit(i, delta_[i]);
+          continue;
+        }
+      }
+    }
+
+    if (delta_[i] == 0)
+    {
+      history_begin_[i] = k + 1;
+      next_tick_time_[i] = t + tick_interval_us_;
+      positive_[i] = positive;
+      horizontal_[i] = horizontal;
+      delta_[i] = initial_delta_[i];
+      speed_[i] = delta_[i] * inv_tick_interval_[i];
+
+      emit(i, delta_[i]);
+      continue;
+    }
+
+    const double speed = smoothSpeed(i, k);
+    if (event_intervals_[k].count() > speed_smooth_window_us_[i])
+    {
+      history_begin_[i] = k + 1;
+    }
+
+    const double min_delta_change = std::min(delta_[i] * min_speed_change_ratio_[i], max_delta_change_lowerbound_[i]);
+    const double max_delta_change = std::max(delta_[i] * max_speed_change_ratio_[i], min_delta_change_upperbound_[i]);
+
+    double delta = std::clamp(speed * tick_interval_, delta_[i] + min_delta_change, delta_[i] + max_delta_change);
+
+    delta_[i] = delta < initial_delta_[i] ? initial_delta_[i] : delta;
+    speed_[i] = delta_[i] * inv_tick_interval_[i];
+    peak_speed_[i] = std::max(peak_speed_[i], speed_[i]);
+  }
+
+  for (size_t i = 0; i < size(); ++i)
+  {
+    against_input_[i] = static_cast<bool>(positive_[i]) != positive ? 1.0 : 0.0;
+  }
+}
+
+void BatchWheelSmoother::tickUntil(std::chrono::microseconds time)
+{
+  const int64_t t = time.count();
+  const size_t n = size();
+
+  double max_ticks = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    num_ticks_[i] = (delta_[i] != 0 && next_tick_time_[i] <= t) ? (t - next_tick_time_[i]) / tick_interval_us_ + 1 : 0;
+    stop_tick_[i] = -1;
+    max_ticks = std::max(max_ticks, num_ticks_[i]);
+  }
+
+  // One round advances every configuration that still has a tick due by one tick.
+  for (double round = 0; round < max_ticks; ++round)
+  {
+    tickRound(n, round, delta_.data(), deviation_.data(), num_ticks_.data(), stop_tick_.data(), distance_.data(),
+              overshoot_.data(), output_events_.data(), alpha_.data(), min_delta_decrease_per_tick_.data(),
+              max_delta_decrease_per_tick_.data(), against_input_.data());
+  }
+
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (stop_tick_[i] >= 0)
+    {
+      stop_time_[i] = next_tick_time_[i] + static_cast<int64_t>(stop_tick_[i]) * tick_interval_us_;
+    }
+
+    if (delta_[i] != 0)
+    {
+      next_tick_time_[i] += static_cast<int64_t>(num_ticks_[i]) * tick_interval_us_;
+      speed_[i] = delta_[i] * inv_tick_interval_[i];
+    }
+    else
+    {
+      speed_[i] = 0;
+    }
+  }
+}
+
+void BatchWheelSmoother::finish()
+{
+  constexpr std::chrono::seconds kStep{ 1 };
+
+  std::chrono::microseconds time = last_event_time_;
+  while (std::any_of(delta_.begin(), delta_.end(), [](double delta) { return delta != 0; }))
+  {
+    time += kStep;
+    tickUntil(time);
+  }
+}
+
+BatchWheelSmoother::Metrics BatchWheelSmoother::metrics(size_t i) const noexcept
+{
+  Metrics metrics;
+  metrics.distance = distance_[i];
+  metrics.overshoot = overshoot_[i];
+  metrics.peak_speed = peak_speed_[i];
+  metrics.time_to_stop_microseconds = std::max<int64_t>(0, stop_time_[i] - last_event_time_.count());
+  metrics.output_events = static_cast<int64_t>(output_events_[i]);
+  return metrics;
+}
+
+}  // namespace smooth_scroll
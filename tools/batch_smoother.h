@@ -0,0 +1,104 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "wheel_smoother.h"
+
+namespace smooth_scroll
+{
+
+// Runs many WheelSmoother configurations over the same wheel event stream in lockstep. State is kept as one array
+// per field so that the per-tick update is a straight loop over configurations the compiler can vectorize.
+//
+// Only the wheel path is modelled: free spin, drag view and mouse movement braking need button and pointer input
+// and are left out. All configurations must share the same tick interval. Ticks are stepped one at a time, so
+// distances and stop times match WheelSmoother ticked the same way, not its closed form tick(n) catch up.
+class BatchWheelSmoother
+{
+public:
+  struct Metrics
+  {
+    double distance;
+    double overshoot;
+    double peak_speed;
+    int64_t time_to_stop_microseconds;
+    int64_t output_events;
+  };
+
+  BatchWheelSmoother(const std::vector<WheelSmoother::Options>& options, size_t begin, size_t end);
+
+  void handleEvent(std::chrono::microseconds time, bool positive, bool horizontal);
+
+  // Runs every tick scheduled at or before `time`.
+  void tickUntil(std::chrono::microseconds time);
+
+  // Runs ticks until all configurations have come to a stop.
+  void finish();
+
+  [[nodiscard]] size_t size() const noexcept
+  {
+    return delta_.size();
+  }
+
+  [[nodiscard]] Metrics metrics(size_t i) const noexcept;
+
+private:
+  double smoothSpeed(size_t i, size_t event_index) const noexcept;
+
+  void emit(size_t i, double delta) noexcept;
+
+  int64_t tick_interval_us_;
+  double tick_interval_;
+
+  // Per-configuration constants.
+  std::vector<double> inv_tick_interval_;
+  std::vector<double> min_delta_decrease_per_tick_;
+  std::vector<double> max_delta_decrease_per_tick_;
+  std::vector<double> initial_delta_;
+  std::vector<double> alpha_;
+  std::vector<double> max_delta_change_lowerbound_;
+  std::vector<double> min_delta_change_upperbound_;
+  std::vector<double> min_speed_change_ratio_;
+  std::vector<double> max_speed_change_ratio_;
+  std::vector<double> speed_factor_;
+  std::vector<int64_t> speed_smooth_window_us_;
+  std::vector<char> use_reverse_scroll_braking_;
+  std::vector<int64_t> max_reverse_scroll_braking_us_;
+  std::vector<int> max_reverse_scroll_braking_times_;
+  std::vector<size_t> braking_table_offset_;
+  std::vector<double> max_delta_braking_times_;
+
+  // Shared event history. Every wheel event updates the last event time of every configuration, so the interval
+  // history of a configuration is always a suffix of this list starting at `history_begin_`.
+  std::vector<std::chrono::microseconds> event_intervals_;
+  std::chrono::microseconds last_event_time_{ 0 };
+
+  // Per-configuration state.
+  std::vector<size_t> history_begin_;
+  std::vector<int64_t> next_tick_time_;
+  std::vector<double> num_ticks_;
+  std::vector<double> stop_tick_;
+  std::vector<int64_t> last_brake_stop_time_;
+  std::vector<int64_t> stop_time_;
+  std::vector<char> positive_;
+  std::vector<char> horizontal_;
+  std::vector<double> delta_;
+  std::vector<double> speed_;
+  std::vector<double> deviation_;
+  std::vector<int> braking_times_;
+
+  // Per-configuration metrics.
+  std::vector<double> distance_;
+  std::vector<double> overshoot_;
+  std::vector<double> against_input_;
+  std::vector<double> peak_speed_;
+  std::vector<double> output_events_;
+};
+
+}  // namespace smooth_scroll
@@ -19,7 +19,8 @@ struct alignas(32) SmoothScrollIPC
   std::atomic<uint32_t> state_bits;
   std::atomic<uint32_t> scroll_id;
   std::atomic<uint32_t> force_passthrough;
-  std::atomic<uint32_t> reserved[3];
+  std::atomic<uint32_t> tick_trace;
+  std::atomic<uint32_t> reserved[2];
 };
 
 static constexpr uint32_t MAGIC_VERSION_EXPECTED = 0x53530001;
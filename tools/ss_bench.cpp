@@ -0,0 +1,519 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "event_loop.h"
+#include "pipe_backend.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+using namespace std::chrono_literals;
+using namespace std::string_view_literals;
+using namespace smooth_scroll;
+
+constexpr std::string_view kHelpStr =
+    R"(End-to-end benchmark of the smooth scroll event loop
+
+Usage: ss-bench [options]
+
+Pushes synthetic pointer, wheel and keyboard traffic through the real event loop
+over pipes and reports throughput, output latency and the heap allocations the
+loop made after startup. Needs no devices or root.
+
+Options:
+  -n, --frames <n>          Pointer frames to send (default 1000000)
+  -w, --wheel-every <n>     Send a wheel notch every n frames, 0 to disable (default 100)
+  -x, --hwheel-every <n>    Send every n-th notch on the horizontal wheel, 0 to disable (default 0)
+  -k, --keyboard-every <n>  Press and release a passthrough key every n frames, 0 to disable (default 0)
+  -r, --rate <hz>           Pace frames at this rate instead of sending as fast as possible
+  -v, --virtual <hz>        Run the loop on a virtual clock and stamp frames at this rate in virtual time,
+                            still sending them as fast as possible
+  -2, --split               Write wheel frames to a second output, as with split_virtual_devices
+  -p, --output-period <us>  Emit smoothed scrolling once per this many microseconds instead of every tick
+  -S, --stall-every <n>     Refuse every n-th write to the outputs, as a full uinput buffer does, so that
+                            frames wait in the output queues
+  -a, --check-allocations   Fail if the event loop allocated after startup
+  -s, --shadow              Copy every frame to a shadow smoother, as the daemon does with [shadow] enabled
+  -j, --journal <file>      Record scroll sessions in a session journal at this path
+  -m, --metrics <file>      Count metrics and write them to this file every second and at the end
+  -c, --calibrate <file>    Measure a device profile from the traffic and save it to this file at the end
+  -R, --runs <n>            Run the benchmark n times and, with --virtual and without --stall-every, fail
+                            unless every run wrote the same output (default 1)
+  -h, --help                Show help message
+)"sv;
+
+namespace
+{
+
+constexpr int kPipeSize = 1 << 20;
+constexpr size_t kBatchFrames = 64;
+constexpr std::chrono::microseconds kVirtualStart = std::chrono::seconds{ 1'000'000'000 };
+
+// Set on the loop's thread only, so the producer's allocations are not counted.
+thread_local bool count_allocations = false;
+uint64_t allocations = 0;
+
+struct timeval toTimeval(std::chrono::microseconds us)
+{
+  struct timeval time;
+  time.tv_sec = us.count() / 1'000'000;
+  time.tv_usec = us.count() % 1'000'000;
+  return time;
+}
+
+bool writeAll(int fd, const std::vector<struct input_event>& events)
+{
+  const char* data = reinterpret_cast<const char*>(events.data());
+  size_t remaining = events.size() * sizeof(struct input_event);
+  while (remaining)
+  {
+    ssize_t n = write(fd, data, remaining);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    data += n;
+    remaining -= n;
+  }
+  return true;
+}
+
+}  // namespace
+
+void* operator new(size_t size)
+{
+  if (count_allocations)
+  {
+    ++allocations;
+  }
+
+  if (void* ptr = std::malloc(size ? size : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+
+namespace
+{
+
+struct BenchOptions
+{
+  long frames = 1'000'000;
+  long wheel_every = 100;
+  long hwheel_every = 0;
+  long keyboard_every = 0;
+  long rate = 0;
+  long virtual_rate = 0;
+  long output_period = 0;
+  long stall_every = 0;
+  bool split = false;
+  bool shadow = false;
+  std::string journal_path;
+  std::string metrics_path;
+  std::string profile_path;
+};
+
+// What one output received, without the latencies, which depend on the machine even on a virtual clock.
+struct OutputStats
+{
+  uint64_t frames = 0;
+  uint64_t events = 0;
+  uint64_t wheel_events = 0;
+  int64_t wheel_distance = 0;
+
+  explicit OutputStats(const MemoryOutputSink& output)
+    : frames{ output.frames() }
+    , events{ output.events() }
+    , wheel_events{ output.wheel_events() }
+    , wheel_distance{ output.wheel_distance() }
+  {
+  }
+
+  bool operator==(const OutputStats& other) const
+  {
+    return frames == other.frames && events == other.events && wheel_events == other.wheel_events &&
+           wheel_distance == other.wheel_distance;
+  }
+};
+
+// Refuses every n-th write as a full uinput buffer would. Its fd is /dev/null, which is always writable, so the loop
+// writes the waiting frames again right away.
+class StallingOutputSink : public OutputSink
+{
+public:
+  StallingOutputSink(OutputSink& sink, long stall_every, int fd) noexcept
+    : sink_{ sink }, stall_every_{ stall_every }, fd_{ fd }
+  {
+  }
+
+  [[nodiscard]] int fd() const noexcept override
+  {
+    return fd_;
+  }
+
+  WriteStatus write(const struct input_event* events, size_t count, size_t& written) noexcept override
+  {
+    if (++writes_ % stall_every_ == 0)
+    {
+      written = 0;
+      return WriteStatus::kAgain;
+    }
+    return sink_.write(events, count, written);
+  }
+
+private:
+  OutputSink& sink_;
+  long stall_every_;
+  int fd_;
+  long writes_ = 0;
+};
+
+struct RunResult
+{
+  OutputStats output;
+  OutputStats wheel_output;
+  uint64_t allocations;
+  uint64_t multi_frame_writes;
+};
+
+// Runs the event loop over one stream of synthetic traffic and prints what came out. Returns nullopt if the run
+// could not be set up.
+std::optional<RunResult> runBench(const BenchOptions& options)
+{
+  IpcServer ipc{ "/smooth_scroll_bench_shm" };
+  if (!ipc.initialize())
+  {
+    std::cerr << "Failed to create IPC shared memory\n";
+    return std::nullopt;
+  }
+
+  int mouse_pipe[2];
+  int keyboard_pipe[2];
+  if (pipe(mouse_pipe) < 0 || pipe(keyboard_pipe) < 0)
+  {
+    std::cerr << "Failed to create pipes\n";
+    return std::nullopt;
+  }
+  fcntl(mouse_pipe[1], F_SETPIPE_SZ, kPipeSize);
+
+  PipeInputSource mouse{ mouse_pipe[0] };
+  std::vector<std::unique_ptr<InputSource>> keyboards;
+  keyboards.push_back(std::make_unique<PipeInputSource>(keyboard_pipe[0]));
+  VirtualClock virtual_clock{ kVirtualStart };
+  virtual_clock.setLimit(kVirtualStart);
+  Clock& clock = options.virtual_rate > 0 ? static_cast<Clock&>(virtual_clock) : SystemClock::instance();
+  MemoryOutputSink output{ clock };
+  MemoryOutputSink wheel_output{ clock };
+  int stall_fd = -1;
+  std::optional<StallingOutputSink> stalling_output;
+  std::optional<StallingOutputSink> stalling_wheel_output;
+  if (options.stall_every > 0)
+  {
+    stall_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (stall_fd < 0)
+    {
+      std::cerr << "Failed to open /dev/null\n";
+      return std::nullopt;
+    }
+    stalling_output.emplace(output, options.stall_every, stall_fd);
+    stalling_wheel_output.emplace(wheel_output, options.stall_every, stall_fd);
+  }
+
+  EventLoop::Options loop_options;
+  loop_options.keyboard_passthrough_keys = { KEY_LEFTCTRL };
+  loop_options.output_period_microseconds = static_cast<int>(options.output_period);
+  loop_options.split_wheel_output = options.split;
+  OutputSink& loop_output = stalling_output ? static_cast<OutputSink&>(*stalling_output) : output;
+  OutputSink& loop_wheel_output =
+      stalling_wheel_output ? static_cast<OutputSink&>(*stalling_wheel_output) : wheel_output;
+  EventLoop loop{ loop_options, WheelSmoother::Options{}, ipc, mouse, std::move(keyboards), loop_output,
+                  options.split ? &loop_wheel_output : nullptr, clock };
+
+  std::optional<ShadowSmoother> shadow;
+  if (options.shadow)
+  {
+    WheelSmoother::Options shadow_options;
+    shadow_options.speed_factor *= 1.5;
+    shadow.emplace(loop_options, WheelSmoother::Options{}, shadow_options, "", clock);
+    shadow->start();
+    loop.setShadow(&*shadow);
+  }
+
+  SessionJournal journal;
+  if (!options.journal_path.empty())
+  {
+    if (!journal.open(options.journal_path))
+    {
+      std::cerr << "Failed to open session journal " << options.journal_path << "\n";
+      return std::nullopt;
+    }
+    loop.setJournal(&journal);
+  }
+
+  Metrics metrics;
+  std::optional<MetricsWriter> metrics_writer;
+  if (!options.metrics_path.empty())
+  {
+    metrics_writer.emplace(metrics, options.metrics_path, std::chrono::seconds{ 1 }, clock);
+    metrics_writer->start();
+    loop.setMetrics(&metrics);
+  }
+
+  std::optional<DeviceCalibrator> calibrator;
+  if (!options.profile_path.empty())
+  {
+    calibrator.emplace(options.profile_path, "ss-bench");
+    loop.setCalibrator(&*calibrator);
+  }
+
+  uint64_t input_events = 0;
+
+  std::thread producer([&]() {
+    std::vector<struct input_event> batch;
+    std::vector<struct input_event> keys;
+    auto start = std::chrono::steady_clock::now();
+
+    for (long frame = 0; frame < options.frames;)
+    {
+      batch.clear();
+
+      for (size_t i = 0; i < kBatchFrames && frame < options.frames; ++i)
+      {
+        struct timeval time = toTimeval(options.virtual_rate > 0
+                                            ? kVirtualStart + frame * 1'000'000us / options.virtual_rate
+                                            : SystemClock::instance().now());
+        if (options.wheel_every && frame % options.wheel_every == 0)
+        {
+          bool horizontal = options.hwheel_every && (frame / options.wheel_every) % options.hwheel_every == 0;
+          uint16_t code = horizontal ? REL_HWHEEL : REL_WHEEL;
+          uint16_t hi_res_code = horizontal ? REL_HWHEEL_HI_RES : REL_WHEEL_HI_RES;
+          batch.push_back({ time, EV_REL, code, 1 });
+          batch.push_back({ time, EV_REL, hi_res_code, 120 });
+        }
+        else
+        {
+          batch.push_back({ time, EV_REL, REL_X, 1 });
+          batch.push_back({ time, EV_REL, REL_Y, -1 });
+        }
+        batch.push_back({ time, EV_SYN, SYN_REPORT, 0 });
+        ++frame;
+
+        if (options.keyboard_every && frame % options.keyboard_every == 0)
+        {
+          keys.clear();
+          keys.push_back({ time, EV_KEY, KEY_LEFTCTRL, (frame / options.keyboard_every) % 2 ? 0 : 1 });
+          keys.push_back({ time, EV_SYN, SYN_REPORT, 0 });
+          input_events += keys.size();
+          writeAll(keyboard_pipe[1], keys);
+        }
+
+        if (options.rate)
+        {
+          std::this_thread::sleep_until(start + std::chrono::microseconds{ frame * 1'000'000 / options.rate });
+          break;
+        }
+      }
+
+      input_events += batch.size();
+      writeAll(mouse_pipe[1], batch);
+
+      if (options.virtual_rate > 0)
+      {
+        virtual_clock.setLimit(kVirtualStart + frame * 1'000'000us / options.virtual_rate);
+      }
+    }
+
+    // The loop exits once the mouse pipe reaches end of file.
+    close(keyboard_pipe[1]);
+    close(mouse_pipe[1]);
+  });
+
+  std::atomic_bool shutdown{ false };
+  auto start = std::chrono::steady_clock::now();
+  allocations = 0;
+  count_allocations = true;
+  loop.run(shutdown);
+  count_allocations = false;
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  producer.join();
+  if (metrics_writer)
+  {
+    metrics_writer->stop();
+  }
+  if (calibrator && !calibrator->save())
+  {
+    std::cerr << "No device profile saved to " << options.profile_path << "\n";
+  }
+
+  std::cout << "input events:  " << input_events << "\n"
+            << "elapsed:       " << elapsed << "s\n"
+            << "throughput:    " << input_events / elapsed << " events/s\n"
+            << "output frames: " << output.frames() << " (" << output.events() << " events, "
+            << output.wheel_events() << " smoothed wheel, " << output.wheel_distance() << " units)\n"
+            << "latency:       avg " << (output.frames() ? output.total_latency().count() / output.frames() : 0)
+            << "us max " << output.max_latency().count() << "us\n"
+            << "allocations:   " << allocations << "\n";
+  if (options.stall_every > 0)
+  {
+    close(stall_fd);
+  }
+  if (options.split)
+  {
+    std::cout << "wheel frames:  " << wheel_output.frames() << " (" << wheel_output.events() << " events, "
+              << wheel_output.wheel_events() << " smoothed wheel, " << wheel_output.wheel_distance() << " units)\n"
+              << "wheel latency: avg "
+              << (wheel_output.frames() ? wheel_output.total_latency().count() / wheel_output.frames() : 0)
+              << "us max " << wheel_output.max_latency().count() << "us\n";
+  }
+  if (options.virtual_rate > 0)
+  {
+    std::cout << "simulated:     " << std::chrono::duration<double>(virtual_clock.now() - kVirtualStart).count()
+              << "s\n";
+  }
+
+  return RunResult{ OutputStats{ output }, OutputStats{ wheel_output }, allocations,
+                    output.multi_frame_writes() + wheel_output.multi_frame_writes() };
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  BenchOptions options;
+  long runs = 1;
+  bool check_allocations = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if ((arg == "-n" || arg == "--frames") && has_value)
+    {
+      options.frames = std::atol(argv[++i]);
+    }
+    else if ((arg == "-w" || arg == "--wheel-every") && has_value)
+    {
+      options.wheel_every = std::atol(argv[++i]);
+    }
+    else if ((arg == "-x" || arg == "--hwheel-every") && has_value)
+    {
+      options.hwheel_every = std::atol(argv[++i]);
+    }
+    else if ((arg == "-k" || arg == "--keyboard-every") && has_value)
+    {
+      options.keyboard_every = std::atol(argv[++i]);
+    }
+    else if ((arg == "-r" || arg == "--rate") && has_value)
+    {
+      options.rate = std::atol(argv[++i]);
+    }
+    else if ((arg == "-v" || arg == "--virtual") && has_value)
+    {
+      options.virtual_rate = std::atol(argv[++i]);
+    }
+    else if (arg == "-2" || arg == "--split")
+    {
+      options.split = true;
+    }
+    else if ((arg == "-p" || arg == "--output-period") && has_value)
+    {
+      options.output_period = std::atol(argv[++i]);
+    }
+    else if ((arg == "-S" || arg == "--stall-every") && has_value)
+    {
+      options.stall_every = std::atol(argv[++i]);
+    }
+    else if (arg == "-a" || arg == "--check-allocations")
+    {
+      check_allocations = true;
+    }
+    else if (arg == "-s" || arg == "--shadow")
+    {
+      options.shadow = true;
+    }
+    else if ((arg == "-j" || arg == "--journal") && has_value)
+    {
+      options.journal_path = argv[++i];
+    }
+    else if ((arg == "-m" || arg == "--metrics") && has_value)
+    {
+      options.metrics_path = argv[++i];
+    }
+    else if ((arg == "-c" || arg == "--calibrate") && has_value)
+    {
+      options.profile_path = argv[++i];
+    }
+    else if ((arg == "-R" || arg == "--runs") && has_value)
+    {
+      runs = std::atol(argv[++i]);
+    }
+    else
+    {
+      std::cout << kHelpStr;
+      return arg == "-h" || arg == "--help" ? 0 : 1;
+    }
+  }
+
+  spdlog::set_level(spdlog::level::off);
+
+  std::optional<RunResult> first;
+  for (long run = 0; run < runs; ++run)
+  {
+    auto result = runBench(options);
+    if (!result)
+      return 1;
+
+    if (check_allocations && result->allocations != 0)
+    {
+      std::cerr << "The event loop allocated after startup\n";
+      return 1;
+    }
+
+    // A sink takes one frame per write, so that the output queue can merge, drop and hold each on its own.
+    if (result->multi_frame_writes != 0)
+    {
+      std::cerr << result->multi_frame_writes << " writes carried more than one frame\n";
+      return 1;
+    }
+
+    // On a virtual clock the same input must play out the same way, however the threads are scheduled. Frames
+    // merged while the output stalls depend on how much input each pass of the loop found.
+    if (!first)
+    {
+      first = result;
+    }
+    else if (options.virtual_rate > 0 && options.stall_every == 0 &&
+             !(result->output == first->output && result->wheel_output == first->wheel_output))
+    {
+      std::cerr << "Run " << run + 1 << " wrote different output from the first\n";
+      return 1;
+    }
+  }
+
+  return 0;
+}
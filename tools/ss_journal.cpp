@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "session_journal.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::string_view_literals;
+using namespace smooth_scroll;
+
+constexpr std::string_view kHelpStr =
+    R"(Summary of the smooth scroll session journal
+
+Usage: ss-journal [options]
+
+Reads the scroll sessions the daemon recorded and prints how many ended for each
+stop reason, and the median and 95th percentile of their duration, distance, peak
+speed and latency.
+
+Options:
+  -f, --file <file>   Journal to read (default: /var/lib/smooth-scroll/sessions.journal)
+  -n, --last <n>      Only the last n sessions
+  -l, --list          Print every session as a CSV line instead
+  -h, --help          Show help message
+)"sv;
+
+namespace
+{
+
+bool load(const std::string& path, std::vector<JournalRecord>& records)
+{
+  std::ifstream file(path, std::ios::binary);
+  JournalHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+  {
+    std::cerr << "Failed to read " << path << "\n";
+    return false;
+  }
+
+  if (header.magic_version != kJournalMagicVersion || header.record_size != sizeof(JournalRecord) ||
+      header.capacity == 0)
+  {
+    std::cerr << path << " is not a session journal of this version\n";
+    return false;
+  }
+
+  std::vector<JournalRecord> ring(header.capacity);
+  if (!file.read(reinterpret_cast<char*>(ring.data()), ring.size() * sizeof(JournalRecord)))
+  {
+    std::cerr << "Failed to read " << path << "\n";
+    return false;
+  }
+
+  uint64_t next = header.next.load(std::memory_order_relaxed);
+  uint64_t first = next > header.capacity ? next - header.capacity : 0;
+  records.reserve(next - first);
+  for (uint64_t i = first; i < next; ++i)
+  {
+    records.push_back(ring[i % header.capacity]);
+  }
+
+  return true;
+}
+
+template <typename T>
+void printPercentiles(std::string_view name, std::vector<T> values, std::string_view unit)
+{
+  if (values.empty())
+    return;
+
+  std::sort(values.begin(), values.end());
+  auto at = [&](double q) { return values[static_cast<size_t>(q * (values.size() - 1))]; };
+  std::cout << name << ": median " << at(0.5) << unit << ", p95 " << at(0.95) << unit << ", max " << values.back()
+            << unit << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::string path = "/var/lib/smooth-scroll/sessions.journal";
+  size_t last = 0;
+  bool list = false;
+  bool show_help = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "-h" || arg == "--help")
+    {
+      show_help = true;
+      break;
+    }
+    else if ((arg == "-f" || arg == "--file") && has_value)
+    {
+      path = argv[++i];
+    }
+    else if ((arg == "-n" || arg == "--last") && has_value)
+    {
+      last = std::max(0L, std::atol(argv[++i]));
+    }
+    else if (arg == "-l" || arg == "--list")
+    {
+      list = true;
+    }
+    else
+    {
+      show_help = true;
+      break;
+    }
+  }
+
+  if (show_help)
+  {
+    std::cout << kHelpStr;
+    return 0;
+  }
+
+  std::vector<JournalRecord> records;
+  if (!load(path, records))
+    return 1;
+
+  if (last && records.size() > last)
+  {
+    records.erase(records.begin(), records.end() - last);
+  }
+
+  if (list)
+  {
+    std::cout << "start_us,duration_us,notches,distance,peak_speed,latency_us,stop_reason,axis\n";
+    for (const auto& record : records)
+    {
+      std::printf("%lld,%lld,%d,%d,%.0f,%lld,%s,%s\n", static_cast<long long>(record.start_us),
+                  static_cast<long long>(record.end_us - record.start_us), record.notches, record.distance,
+                  record.peak_speed, static_cast<long long>(record.latency_us), stopReasonName(record.stop_reason),
+                  record.horizontal ? "horizontal" : "vertical");
+    }
+    return 0;
+  }
+
+  std::cout << records.size() << " sessions\n";
+  if (records.empty())
+    return 0;
+
+  std::vector<size_t> reasons;
+  std::vector<int64_t> durations;
+  std::vector<int> distances;
+  std::vector<int> notches;
+  std::vector<int64_t> peak_speeds;
+  std::vector<int64_t> latencies;
+  for (const auto& record : records)
+  {
+    if (record.stop_reason >= reasons.size())
+    {
+      reasons.resize(record.stop_reason + 1);
+    }
+    ++reasons[record.stop_reason];
+
+    durations.push_back((record.end_us - record.start_us) / 1000);
+    distances.push_back(record.distance);
+    notches.push_back(record.notches);
+    peak_speeds.push_back(static_cast<int64_t>(record.peak_speed));
+    latencies.push_back(record.latency_us);
+  }
+
+  std::cout << "\nStop reasons:\n";
+  for (size_t reason = 0; reason < reasons.size(); ++reason)
+  {
+    if (reasons[reason])
+    {
+      std::printf("  %-16s %6zu  %5.1f%%\n", stopReasonName(static_cast<int>(reason)), reasons[reason],
+                  100.0 * reasons[reason] / records.size());
+    }
+  }
+
+  std::cout << "\n";
+  printPercentiles("Duration", std::move(durations), "ms");
+  printPercentiles("Notches", std::move(notches), "");
+  printPercentiles("Distance", std::move(distances), " units");
+  printPercentiles("Peak speed", std::move(peak_speeds), " units/s");
+  printPercentiles("Latency", std::move(latencies), "us");
+
+  return 0;
+}
@@ -0,0 +1,820 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "event_router.h"
+#include "wheel_smoother.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+using namespace std::string_view_literals;
+using namespace smooth_scroll;
+
+constexpr std::string_view kHelpStr =
+    R"(Golden trajectory replay for the smooth scroll wheel smoother
+
+Usage: ss-replay [options] [gesture...]
+
+Runs canonical gestures through WheelSmoother with the default options and prints
+every emitted event in evemu-record format. Fails if a gesture needs more ticks or
+output events than its budget, or if the output differs from a golden file. Gestures
+named routed_* go through EventRouter, as the daemon's event loop drives it, and fail
+if the scroll position differs from that of the same events fed to WheelSmoother one
+by one.
+
+Options:
+  -c, --check <file>  Compare the output against a golden file produced earlier
+  -f, --fixed         Also replay through the fixed point smoother and fail if its
+                      scroll position ever differs by more than one hi-res unit
+  -b, --bench <n>     Replay every gesture n times through both smoothers and print
+                      the time per tick; then time the smoother calls alone,
+                      without the replay harness
+  -l, --list          List the available gestures
+  -h, --help          Show help message
+)"sv;
+
+namespace
+{
+
+// The smoother EventRouter runs.
+#ifdef SMOOTH_SCROLL_FIXED_POINT
+using RouterWheelSmoother = FixedWheelSmoother;
+#else
+using RouterWheelSmoother = WheelSmoother;
+#endif
+
+constexpr int kFreeSpinButton = BTN_RIGHT;
+constexpr int kDragViewButton = BTN_LEFT;
+
+struct Step
+{
+  int64_t time;
+  uint16_t type;
+  uint16_t code;
+  int32_t value;
+};
+
+struct Gesture
+{
+  std::string_view name;
+  int max_ticks;
+  int max_output_events;
+  std::vector<Step> steps;
+  // Routes the gesture through an EventRouter with these options instead of driving WheelSmoother directly.
+  std::optional<EventRouter::Options> router = std::nullopt;
+};
+
+// Builds input in the shape the kernel delivers it: every call is one frame terminated by SYN_REPORT.
+class GestureBuilder
+{
+public:
+  GestureBuilder& after(int64_t delay)
+  {
+    time_ += delay;
+    return *this;
+  }
+
+  GestureBuilder& frame(std::initializer_list<std::pair<uint16_t, int32_t>> events, uint16_t type = EV_REL)
+  {
+    for (const auto& [code, value] : events)
+    {
+      steps_.push_back(Step{ time_, type, code, value });
+    }
+    steps_.push_back(Step{ time_, EV_SYN, SYN_REPORT, 0 });
+    return *this;
+  }
+
+  // One frame of events of any type, in the order given.
+  GestureBuilder& typedFrame(std::initializer_list<std::tuple<uint16_t, uint16_t, int32_t>> events)
+  {
+    for (const auto& [type, code, value] : events)
+    {
+      steps_.push_back(Step{ time_, type, code, value });
+    }
+    steps_.push_back(Step{ time_, EV_SYN, SYN_REPORT, 0 });
+    return *this;
+  }
+
+  GestureBuilder& notches(int count, int64_t interval, int32_t value = 1, uint16_t code = REL_WHEEL)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      if (i)
+      {
+        after(interval);
+      }
+      frame({ { code, value }, { code == REL_WHEEL ? REL_WHEEL_HI_RES : REL_HWHEEL_HI_RES, value * 120 } });
+    }
+    return *this;
+  }
+
+  GestureBuilder& button(uint16_t code, int32_t value)
+  {
+    return frame({ { code, value } }, EV_KEY);
+  }
+
+  GestureBuilder& move(int count, int64_t interval, int32_t x, int32_t y)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      after(interval);
+      frame({ { REL_X, x }, { REL_Y, y } });
+    }
+    return *this;
+  }
+
+  std::vector<Step> build()
+  {
+    return std::move(steps_);
+  }
+
+private:
+  int64_t time_ = 1'000'000;
+  std::vector<Step> steps_;
+};
+
+std::vector<Gesture> canonicalGestures()
+{
+  std::vector<Gesture> gestures;
+
+  gestures.push_back({ "single_notch", 250, 150, GestureBuilder{}.notches(1, 0).build() });
+
+  gestures.push_back({ "single_notch_horizontal", 250, 150,
+                       GestureBuilder{}.notches(1, 0, -1, REL_HWHEEL).build() });
+
+  gestures.push_back({ "slow_scroll", 600, 480, GestureBuilder{}.notches(5, 150'000).build() });
+
+  gestures.push_back({ "fling", 600, 500, GestureBuilder{}.notches(12, 25'000).build() });
+
+  gestures.push_back({ "fling_down", 600, 500, GestureBuilder{}.notches(12, 25'000, -1).build() });
+
+  // A fast spin the device reports three notches at a time: each report counts as three notches for the speed.
+  gestures.push_back({ "batched_fling", 600, 500, GestureBuilder{}.notches(4, 75'000, 3).build() });
+
+  // Reverse notch stops the fling, two more inside the braking window are swallowed as jitter and the one after
+  // the window starts scrolling the other way.
+  gestures.push_back({ "reverse_brake_dejitter", 400, 300,
+                       GestureBuilder{}
+                           .notches(8, 30'000)
+                           .after(40'000)
+                           .notches(3, 30'000, -1)
+                           .after(200'000)
+                           .notches(1, 0, -1)
+                           .build() });
+
+  gestures.push_back({ "free_spin", 1400, 1300,
+                       GestureBuilder{}
+                           .notches(6, 30'000)
+                           .after(50'000)
+                           .button(kFreeSpinButton, 1)
+                           .after(1'500'000)
+                           .button(kFreeSpinButton, 0)
+                           .build() });
+
+  gestures.push_back({ "drag_view", 100, 140,
+                       GestureBuilder{}
+                           .notches(5, 30'000)
+                           .after(20'000)
+                           .button(kDragViewButton, 1)
+                           .move(20, 8'000, 3, -2)
+                           .after(8'000)
+                           .button(kDragViewButton, 0)
+                           .build() });
+
+  // Pointer movement inside mouse_movement_delay_microseconds is ignored, movement after it stops the scroll.
+  gestures.push_back({ "mouse_movement_braking", 160, 260,
+                       GestureBuilder{}.notches(6, 30'000).move(20, 4'000, 8, 0).move(20, 4'000, 8, 0).build() });
+
+  // Movement exactly mouse_movement_delay_microseconds after the last notch is still ignored; one microsecond later
+  // the same movement stops the scroll.
+  gestures.push_back({ "mouse_movement_delay_boundary", 160, 260,
+                       GestureBuilder{}
+                           .notches(6, 30'000)
+                           .after(100'000)
+                           .frame({ { REL_X, 40 } })
+                           .after(1)
+                           .frame({ { REL_X, 40 } })
+                           .build() });
+
+  gestures.push_back({ "button_click_stop", 150, 160,
+                       GestureBuilder{}
+                           .notches(6, 30'000)
+                           .after(100'000)
+                           .button(BTN_MIDDLE, 1)
+                           .after(80'000)
+                           .button(BTN_MIDDLE, 0)
+                           .build() });
+
+  // A notch and a click in the same frame: the notch counts first, as the mouse sent it, so the click stops the
+  // scroll it continued rather than a new one starting after the click.
+  gestures.push_back({ "routed_notch_then_click", 150, 160,
+                       GestureBuilder{}
+                           .notches(6, 30'000)
+                           .after(30'000)
+                           .typedFrame({ { EV_REL, REL_WHEEL, 1 }, { EV_REL, REL_WHEEL_HI_RES, 120 },
+                                         { EV_KEY, BTN_MIDDLE, 1 } })
+                           .after(80'000)
+                           .button(BTN_MIDDLE, 0)
+                           .build(),
+                       EventRouter::Options{} });
+
+  // Drag view with the wheel on a device of its own: the motion it turns into scrolling has to reach the wheel device,
+  // since the pointer device has no wheel codes.
+  EventRouter::Options split;
+  split.split_wheel_output = true;
+  gestures.push_back({ "routed_drag_view_split", 100, 140,
+                       GestureBuilder{}
+                           .notches(5, 30'000)
+                           .after(20'000)
+                           .button(kDragViewButton, 1)
+                           .move(20, 8'000, 3, -2)
+                           .after(8'000)
+                           .button(kDragViewButton, 0)
+                           .build(),
+                       split });
+
+  return gestures;
+}
+
+void printEvent(std::string& out, const struct input_event& ev)
+{
+  char line[64];
+  std::snprintf(line, sizeof(line), "E: %ld.%06ld %04x %04x %d\n", static_cast<long>(ev.time.tv_sec),
+                static_cast<long>(ev.time.tv_usec), ev.type, ev.code, ev.value);
+  out += line;
+}
+
+// Scroll position in hi-res units after the frame written at `time`.
+struct Position
+{
+  int64_t time;
+  int64_t vertical;
+  int64_t horizontal;
+};
+
+struct ReplayResult
+{
+  std::string output;
+  int ticks = 0;
+  int output_events = 0;
+  std::vector<Position> positions;
+};
+
+// Routes the gesture through the smoother the way the daemon main loop does and records every frame it would
+// write to uinput. Ticks due at or before an input event run before it. Without `record` only the counts are kept.
+template <typename Smoother>
+ReplayResult replay(const Gesture& gesture, bool record = true)
+{
+  ReplayResult result;
+  std::ostringstream out;
+  Smoother wheel_smoother{ WheelSmoother::Options{} };
+  Position position{};
+  std::vector<struct input_event> events;
+
+  auto print = [&](const struct input_event& ev) {
+    if (!record)
+      return;
+
+    std::string line;
+    printEvent(line, ev);
+    out << line;
+  };
+
+  auto write_events = [&](const timeval& time) {
+    if (events.empty())
+      return;
+
+    events.push_back({ time, EV_SYN, SYN_REPORT, 0 });
+    for (const auto& ev : events)
+    {
+      print(ev);
+      if (ev.type == EV_REL && ev.code == REL_WHEEL_HI_RES)
+      {
+        position.vertical += ev.value;
+      }
+      else if (ev.type == EV_REL && ev.code == REL_HWHEEL_HI_RES)
+      {
+        position.horizontal += ev.value;
+      }
+    }
+    position.time = time.tv_sec * int64_t{ 1'000'000 } + time.tv_usec;
+    if (record)
+    {
+      result.positions.push_back(position);
+    }
+    result.output_events += events.size() - 1;
+    events.clear();
+  };
+
+  auto tick_until = [&](int64_t time) {
+    while (auto next_tick_time = wheel_smoother.next_tick_time())
+    {
+      if (next_tick_time->count() > time)
+        break;
+
+      ++result.ticks;
+      if (auto ev_wheel = wheel_smoother.tick())
+      {
+        events.push_back(*ev_wheel);
+        write_events(ev_wheel->time);
+      }
+    }
+  };
+
+  out << "# gesture " << gesture.name << "\n";
+
+  for (const auto& step : gesture.steps)
+  {
+    tick_until(step.time);
+
+    struct input_event ev;
+    ev.time.tv_sec = step.time / 1'000'000;
+    ev.time.tv_usec = step.time % 1'000'000;
+    ev.type = step.type;
+    ev.code = step.code;
+    ev.value = step.value;
+
+    switch (ev.type)
+    {
+      case EV_REL:
+        switch (ev.code)
+        {
+          case REL_WHEEL:
+          case REL_HWHEEL:
+            if (auto ev_wheel =
+                    wheel_smoother.handleEvent(ev.time, ev.value > 0, ev.code == REL_HWHEEL, std::abs(ev.value)))
+            {
+              events.push_back(*ev_wheel);
+            }
+            break;
+
+          case REL_WHEEL_HI_RES:
+          case REL_HWHEEL_HI_RES:
+            break;
+
+          case REL_X:
+            wheel_smoother.handleRelXEvent(ev);
+            events.push_back(ev);
+            break;
+
+          case REL_Y:
+            wheel_smoother.handleRelYEvent(ev);
+            events.push_back(ev);
+            break;
+
+          default:
+            events.push_back(ev);
+            break;
+        }
+        break;
+
+      case EV_KEY: {
+        bool handled = false;
+
+        if (ev.code == kDragViewButton)
+        {
+          handled = wheel_smoother.handleDragViewButton(ev.value);
+        }
+        else if (ev.code == kFreeSpinButton)
+        {
+          handled = wheel_smoother.handleFreeSpinButton(ev.value);
+        }
+
+        if (!handled)
+        {
+          wheel_smoother.stop();
+          events.push_back(ev);
+        }
+        break;
+      }
+
+      case EV_SYN:
+        if (ev.code == SYN_REPORT)
+        {
+          wheel_smoother.handleReportEvent(ev.time);
+          write_events(ev.time);
+        }
+        break;
+
+      default:
+        events.push_back(ev);
+        break;
+    }
+  }
+
+  tick_until(std::numeric_limits<int64_t>::max());
+
+  out << "# ticks " << result.ticks << " output_events " << result.output_events << "\n";
+  result.output = out.str();
+  return result;
+}
+
+// Routes the gesture through EventRouter the way the daemon's event loop drives it: every tick runs at the time it
+// falls due, and input is handled event by event. Frames for the pointer device are printed first; with
+// split_wheel_output the wheel device's follow after a "# device wheel" line.
+ReplayResult replayRouter(const Gesture& gesture, const EventRouter::Options& options)
+{
+  ReplayResult result;
+  EventRouter router{ options, WheelSmoother::Options{} };
+  Position position{};
+  std::string pointer_lines;
+  std::string wheel_lines;
+
+  auto collect = [&](int64_t time) {
+    bool wrote = false;
+    for (auto [events, lines] : { std::pair{ &router.output(), &pointer_lines },
+                                  std::pair{ &router.wheel_output(), &wheel_lines } })
+    {
+      for (const auto& ev : *events)
+      {
+        printEvent(*lines, ev);
+        if (ev.type == EV_SYN)
+          continue;
+
+        wrote = true;
+        ++result.output_events;
+        if (ev.type == EV_REL && ev.code == REL_WHEEL_HI_RES)
+        {
+          position.vertical += ev.value;
+        }
+        else if (ev.type == EV_REL && ev.code == REL_HWHEEL_HI_RES)
+        {
+          position.horizontal += ev.value;
+        }
+      }
+    }
+    router.clearOutput();
+
+    if (wrote)
+    {
+      position.time = time;
+      result.positions.push_back(position);
+    }
+  };
+
+  auto tick_until = [&](int64_t time) {
+    while (auto next_tick_time = router.next_tick_time())
+    {
+      if (next_tick_time->count() > time)
+        break;
+
+      ++result.ticks;
+      router.tick(*next_tick_time);
+      collect(next_tick_time->count());
+    }
+  };
+
+  for (const auto& step : gesture.steps)
+  {
+    tick_until(step.time);
+
+    struct input_event ev;
+    ev.time.tv_sec = step.time / 1'000'000;
+    ev.time.tv_usec = step.time % 1'000'000;
+    ev.type = step.type;
+    ev.code = step.code;
+    ev.value = step.value;
+    router.handleMouseEvent(ev);
+    collect(step.time);
+  }
+
+  tick_until(std::numeric_limits<int64_t>::max());
+
+  result.output = "# gesture " + std::string{ gesture.name } + "\n" + pointer_lines;
+  if (options.split_wheel_output)
+  {
+    result.output += "# device wheel\n" + wheel_lines;
+  }
+  result.output +=
+      "# ticks " + std::to_string(result.ticks) + " output_events " + std::to_string(result.output_events) + "\n";
+  return result;
+}
+
+Position positionAt(const std::vector<Position>& positions, int64_t time)
+{
+  auto it = std::upper_bound(positions.begin(), positions.end(), time,
+                             [](int64_t t, const Position& position) { return t < position.time; });
+  return it == positions.begin() ? Position{ time, 0, 0 } : *std::prev(it);
+}
+
+// Largest difference in scroll position between the two replays at any time either of them wrote a frame.
+int64_t maxPositionError(const ReplayResult& a, const ReplayResult& b)
+{
+  int64_t max_error = 0;
+  for (const auto* positions : { &a.positions, &b.positions })
+  {
+    for (const auto& position : *positions)
+    {
+      auto pa = positionAt(a.positions, position.time);
+      auto pb = positionAt(b.positions, position.time);
+      max_error = std::max({ max_error, std::abs(pa.vertical - pb.vertical), std::abs(pa.horizontal - pb.horizontal) });
+    }
+  }
+  return max_error;
+}
+
+template <typename Smoother>
+double nanosecondsPerTick(const std::vector<Gesture>& gestures, int repeat)
+{
+  int64_t ticks = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i)
+  {
+    for (const auto& gesture : gestures)
+    {
+      ticks += replay<Smoother>(gesture, false).ticks;
+    }
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return ticks ? elapsed.count() / ticks : 0;
+}
+
+bool checkBudgets(const Gesture& gesture, const ReplayResult& result)
+{
+  bool ok = true;
+  if (result.ticks > gesture.max_ticks)
+  {
+    std::cerr << gesture.name << ": " << result.ticks << " ticks exceed budget of " << gesture.max_ticks << "\n";
+    ok = false;
+  }
+
+  if (result.output_events > gesture.max_output_events)
+  {
+    std::cerr << gesture.name << ": " << result.output_events << " output events exceed budget of "
+              << gesture.max_output_events << "\n";
+    ok = false;
+  }
+  return ok;
+}
+
+volatile int64_t bench_sink = 0;
+
+// Makes the same smoother calls as replay() and nothing else: no output is recorded, and the smoothers are built
+// before the clock starts, so the time is that of tick(), handleEvent() and the other entry points alone.
+template <typename Smoother>
+double nanosecondsPerCall(const std::vector<Gesture>& gestures, int repeat)
+{
+  int64_t calls = 0;
+  int64_t checksum = 0;
+  std::chrono::nanoseconds elapsed{ 0 };
+
+  for (int i = 0; i < repeat; ++i)
+  {
+    for (const auto& gesture : gestures)
+    {
+      Smoother wheel_smoother{ WheelSmoother::Options{} };
+
+      auto start = std::chrono::steady_clock::now();
+      auto tick_until = [&](int64_t time) {
+        while (auto next_tick_time = wheel_smoother.next_tick_time())
+        {
+          if (next_tick_time->count() > time)
+            break;
+
+          ++calls;
+          if (auto ev_wheel = wheel_smoother.tick())
+          {
+            checksum += ev_wheel->value;
+          }
+        }
+      };
+
+      for (const auto& step : gesture.steps)
+      {
+        tick_until(step.time);
+
+        struct input_event ev;
+        ev.time.tv_sec = step.time / 1'000'000;
+        ev.time.tv_usec = step.time % 1'000'000;
+        ev.type = step.type;
+        ev.code = step.code;
+        ev.value = step.value;
+        ++calls;
+
+        if (ev.type == EV_REL && (ev.code == REL_WHEEL || ev.code == REL_HWHEEL))
+        {
+          if (auto ev_wheel =
+                  wheel_smoother.handleEvent(ev.time, ev.value > 0, ev.code == REL_HWHEEL, std::abs(ev.value)))
+          {
+            checksum += ev_wheel->value;
+          }
+        }
+        else if (ev.type == EV_REL && ev.code == REL_X)
+        {
+          wheel_smoother.handleRelXEvent(ev);
+        }
+        else if (ev.type == EV_REL && ev.code == REL_Y)
+        {
+          wheel_smoother.handleRelYEvent(ev);
+        }
+        else if (ev.type == EV_KEY)
+        {
+          bool handled = ev.code == kDragViewButton   ? wheel_smoother.handleDragViewButton(ev.value)
+                         : ev.code == kFreeSpinButton ? wheel_smoother.handleFreeSpinButton(ev.value)
+                                                      : false;
+          if (!handled)
+          {
+            wheel_smoother.stop();
+          }
+        }
+        else if (ev.type == EV_SYN && ev.code == SYN_REPORT)
+        {
+          wheel_smoother.handleReportEvent(ev.time);
+        }
+      }
+
+      tick_until(std::numeric_limits<int64_t>::max());
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+  }
+
+  // Keeps the calls from being optimized away.
+  bench_sink = checksum;
+  return calls ? static_cast<double>(elapsed.count()) / calls : 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  std::string golden_path;
+  std::vector<std::string_view> selected;
+  bool show_help = false;
+  bool list = false;
+  bool fixed = false;
+  int bench_repeat = 0;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view arg = argv[i];
+    if (arg == "-h" || arg == "--help")
+    {
+      show_help = true;
+      break;
+    }
+    else if (arg == "-l" || arg == "--list")
+    {
+      list = true;
+    }
+    else if (arg == "-f" || arg == "--fixed")
+    {
+      fixed = true;
+    }
+    else if ((arg == "-b" || arg == "--bench") && i + 1 < argc)
+    {
+      bench_repeat = std::atoi(argv[++i]);
+    }
+    else if (arg == "-c" || arg == "--check")
+    {
+      if (i + 1 < argc)
+      {
+        golden_path = argv[++i];
+      }
+      else
+      {
+        show_help = true;
+        break;
+      }
+    }
+    else if (!arg.empty() && arg[0] != '-')
+    {
+      selected.push_back(arg);
+    }
+    else
+    {
+      show_help = true;
+      break;
+    }
+  }
+
+  if (show_help)
+  {
+    std::cout << kHelpStr;
+    return 0;
+  }
+
+  auto gestures = canonicalGestures();
+
+  if (list)
+  {
+    for (const auto& gesture : gestures)
+    {
+      std::cout << gesture.name << "\n";
+    }
+    return 0;
+  }
+
+  if (!selected.empty())
+  {
+    gestures.erase(std::remove_if(gestures.begin(), gestures.end(),
+                                  [&](const Gesture& gesture) {
+                                    return std::find(selected.begin(), selected.end(), gesture.name) ==
+                                           selected.end();
+                                  }),
+                   gestures.end());
+  }
+
+  if (bench_repeat > 0)
+  {
+    // Warm up caches and the branch predictor before timing either one.
+    nanosecondsPerTick<WheelSmoother>(gestures, 1);
+    nanosecondsPerTick<FixedWheelSmoother>(gestures, 1);
+    std::printf("double: %.1f ns/tick\n", nanosecondsPerTick<WheelSmoother>(gestures, bench_repeat));
+    std::printf("fixed:  %.1f ns/tick\n", nanosecondsPerTick<FixedWheelSmoother>(gestures, bench_repeat));
+
+    // The same comparison without the replay harness around the calls.
+    nanosecondsPerCall<WheelSmoother>(gestures, 1);
+    nanosecondsPerCall<FixedWheelSmoother>(gestures, 1);
+    std::printf("smoother calls only, double: %.2f ns/call\n",
+                nanosecondsPerCall<WheelSmoother>(gestures, bench_repeat));
+    std::printf("smoother calls only, fixed:  %.2f ns/call\n",
+                nanosecondsPerCall<FixedWheelSmoother>(gestures, bench_repeat));
+    return 0;
+  }
+
+  bool failed = false;
+  std::string output;
+
+  for (const auto& gesture : gestures)
+  {
+    if (gesture.router)
+    {
+      auto result = replayRouter(gesture, *gesture.router);
+      output += result.output;
+      failed |= !checkBudgets(gesture, result);
+
+      int64_t error = maxPositionError(result, replay<RouterWheelSmoother>(gesture));
+      if (error != 0)
+      {
+        std::cerr << gesture.name << ": position through EventRouter differs by up to " << error
+                  << " hi-res units from the events fed one by one\n";
+        failed = true;
+      }
+      continue;
+    }
+
+    auto result = replay<WheelSmoother>(gesture);
+    output += result.output;
+
+    if (fixed)
+    {
+      auto fixed_result = replay<FixedWheelSmoother>(gesture);
+      int64_t error = maxPositionError(result, fixed_result);
+      if (error > 1)
+      {
+        std::cerr << gesture.name << ": fixed point position differs by up to " << error << " hi-res units\n";
+        failed = true;
+      }
+    }
+
+    failed |= !checkBudgets(gesture, result);
+  }
+
+  if (golden_path.empty())
+  {
+    std::cout << output;
+    return failed ? 1 : 0;
+  }
+
+  std::ifstream golden_file(golden_path);
+  if (!golden_file)
+  {
+    std::cerr << "Failed to read golden file " << golden_path << "\n";
+    return 1;
+  }
+
+  std::istringstream actual(output);
+  std::string expected_line;
+  std::string actual_line;
+  int line = 0;
+  while (true)
+  {
+    bool has_expected = static_cast<bool>(std::getline(golden_file, expected_line));
+    bool has_actual = static_cast<bool>(std::getline(actual, actual_line));
+    ++line;
+
+    if (!has_expected && !has_actual)
+      break;
+
+    if (has_expected != has_actual || expected_line != actual_line)
+    {
+      std::cerr << golden_path << ":" << line << ": expected '" << (has_expected ? expected_line : "<eof>")
+                << "' got '" << (has_actual ? actual_line : "<eof>") << "'\n";
+      failed = true;
+      break;
+    }
+  }
+
+  return failed ? 1 : 0;
+}
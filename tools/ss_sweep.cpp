@@ -0,0 +1,427 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2026 Wayne6530
+
+#include "batch_smoother.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std::string_view_literals;
+using namespace smooth_scroll;
+
+constexpr std::string_view kHelpStr =
+    R"(Offline parameter sweep for the smooth scroll wheel smoother
+
+Usage: ss-sweep [options] -p <name>=<min>:<max>:<steps> [-p ...]
+
+Simulates every combination of the swept parameters over a wheel event trace and
+prints one CSV row of metrics per combination.
+
+Options:
+  -t, --trace <file>          Replay REL_WHEEL/REL_HWHEEL events from an evemu-record trace
+  -s, --synthetic <spec>      Synthesize a gesture: <notches>:<interval_us>[:<reverse_after_us>]
+  -p, --param <sweep>         Sweep an option linearly: <name>=<min>:<max>:<steps>
+      --set <name>=<value>    Override a base option for all combinations
+  -c, --check                 Also run every combination through WheelSmoother, ticked one tick at a
+                              time as the event loop does, and fail if its distance or time to stop
+                              differs
+  -j, --jobs <n>              Number of worker threads (default: all cores)
+  -h, --help                  Show help message
+)"sv;
+
+namespace
+{
+
+struct OptionField
+{
+  std::string_view name;
+  void (*set)(WheelSmoother::Options&, double);
+};
+
+template <auto Field>
+void setField(WheelSmoother::Options& options, double value)
+{
+  using T = std::remove_reference_t<decltype(options.*Field)>;
+  options.*Field = static_cast<T>(std::is_floating_point_v<T> ? value : std::round(value));
+}
+
+const OptionField kOptionFields[] = {
+  { "tick_interval_microseconds"sv, &setField<&WheelSmoother::Options::tick_interval_microseconds> },
+  { "min_deceleration"sv, &setField<&WheelSmoother::Options::min_deceleration> },
+  { "max_deceleration"sv, &setField<&WheelSmoother::Options::max_deceleration> },
+  { "initial_speed"sv, &setField<&WheelSmoother::Options::initial_speed> },
+  { "speed_factor"sv, &setField<&WheelSmoother::Options::speed_factor> },
+  { "speed_smooth_window_microseconds"sv, &setField<&WheelSmoother::Options::speed_smooth_window_microseconds> },
+  { "max_speed_change_lowerbound"sv, &setField<&WheelSmoother::Options::max_speed_change_lowerbound> },
+  { "min_speed_change_upperbound"sv, &setField<&WheelSmoother::Options::min_speed_change_upperbound> },
+  { "min_speed_change_ratio"sv, &setField<&WheelSmoother::Options::min_speed_change_ratio> },
+  { "max_speed_change_ratio"sv, &setField<&WheelSmoother::Options::max_speed_change_ratio> },
+  { "damping"sv, &setField<&WheelSmoother::Options::damping> },
+  { "use_reverse_scroll_braking"sv, &setField<&WheelSmoother::Options::use_reverse_scroll_braking> },
+  { "max_reverse_scroll_braking_microseconds"sv,
+    &setField<&WheelSmoother::Options::max_reverse_scroll_braking_microseconds> },
+  { "max_reverse_scroll_braking_times"sv, &setField<&WheelSmoother::Options::max_reverse_scroll_braking_times> },
+};
+
+const OptionField* findField(std::string_view name)
+{
+  for (const auto& field : kOptionFields)
+  {
+    if (field.name == name)
+    {
+      return &field;
+    }
+  }
+  return nullptr;
+}
+
+struct Sweep
+{
+  const OptionField* field;
+  std::vector<double> values;
+};
+
+struct WheelEvent
+{
+  std::chrono::microseconds time;
+  bool positive;
+  bool horizontal;
+};
+
+bool parseSweep(std::string_view arg, Sweep& sweep)
+{
+  auto eq = arg.find('=');
+  if (eq == std::string_view::npos)
+  {
+    return false;
+  }
+
+  sweep.field = findField(arg.substr(0, eq));
+  if (!sweep.field || sweep.field->name == "tick_interval_microseconds")
+  {
+    return false;
+  }
+
+  double min = 0;
+  double max = 0;
+  int steps = 0;
+  std::string range(arg.substr(eq + 1));
+  if (std::sscanf(range.c_str(), "%lf:%lf:%d", &min, &max, &steps) != 3 || steps < 1)
+  {
+    return false;
+  }
+
+  for (int i = 0; i < steps; ++i)
+  {
+    sweep.values.push_back(steps == 1 ? min : min + (max - min) * i / (steps - 1));
+  }
+  return true;
+}
+
+bool parseSet(std::string_view arg, WheelSmoother::Options& options)
+{
+  auto eq = arg.find('=');
+  if (eq == std::string_view::npos)
+  {
+    return false;
+  }
+
+  const OptionField* field = findField(arg.substr(0, eq));
+  if (!field)
+  {
+    return false;
+  }
+
+  field->set(options, std::strtod(std::string(arg.substr(eq + 1)).c_str(), nullptr));
+  return true;
+}
+
+bool loadTrace(const std::string& path, std::vector<WheelEvent>& events)
+{
+  std::ifstream file(path);
+  if (!file)
+  {
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(file, line))
+  {
+    long sec = 0;
+    long usec = 0;
+    unsigned int type = 0;
+    unsigned int code = 0;
+    int value = 0;
+    if (std::sscanf(line.c_str(), "E: %ld.%ld %x %x %d", &sec, &usec, &type, &code, &value) != 5)
+    {
+      continue;
+    }
+
+    if (type == EV_REL && (code == REL_WHEEL || code == REL_HWHEEL) && value != 0)
+    {
+      events.push_back(
+          WheelEvent{ std::chrono::seconds{ sec } + std::chrono::microseconds{ usec }, value > 0, code == REL_HWHEEL });
+    }
+  }
+  return true;
+}
+
+bool synthesize(std::string_view spec, std::vector<WheelEvent>& events)
+{
+  int notches = 0;
+  long interval = 0;
+  long reverse_after = -1;
+  std::string str(spec);
+  if (std::sscanf(str.c_str(), "%d:%ld:%ld", &notches, &interval, &reverse_after) < 2 || notches < 1 || interval < 1)
+  {
+    return false;
+  }
+
+  // Gestures given one after another are separated by a second of idle time.
+  std::chrono::microseconds time = (events.empty() ? std::chrono::microseconds{ 0 } : events.back().time) +
+                                   std::chrono::seconds{ 1 };
+  for (int i = 0; i < notches; ++i)
+  {
+    events.push_back(WheelEvent{ time, true, false });
+    time += std::chrono::microseconds{ interval };
+  }
+
+  if (reverse_after >= 0)
+  {
+    events.push_back(WheelEvent{ events.back().time + std::chrono::microseconds{ reverse_after }, false, false });
+  }
+  return true;
+}
+
+// What WheelSmoother makes of the same events, driven the way the event loop drives it while it keeps up: every
+// tick on its own, and the ticks due at or before an event before it.
+BatchWheelSmoother::Metrics referenceMetrics(const WheelSmoother::Options& options,
+                                             const std::vector<WheelEvent>& events)
+{
+  WheelSmoother wheel_smoother{ options };
+  BatchWheelSmoother::Metrics metrics{};
+  std::chrono::microseconds stop_time{ 0 };
+
+  auto collect = [&](const std::optional<struct input_event>& ev) {
+    if (ev)
+    {
+      metrics.distance += std::abs(ev->value);
+      ++metrics.output_events;
+    }
+  };
+
+  auto tick_until = [&](std::chrono::microseconds time) {
+    while (auto next_tick_time = wheel_smoother.next_tick_time())
+    {
+      if (*next_tick_time > time)
+        break;
+
+      collect(wheel_smoother.tick());
+      if (!wheel_smoother.next_tick_time())
+      {
+        stop_time = *next_tick_time;
+      }
+    }
+  };
+
+  for (const auto& event : events)
+  {
+    tick_until(event.time);
+
+    bool scrolling = wheel_smoother.next_tick_time().has_value();
+    struct timeval time;
+    time.tv_sec = event.time.count() / 1'000'000;
+    time.tv_usec = event.time.count() % 1'000'000;
+    collect(wheel_smoother.handleEvent(time, event.positive, event.horizontal));
+    if (scrolling && !wheel_smoother.next_tick_time())
+    {
+      stop_time = event.time;
+    }
+  }
+  tick_until(std::chrono::microseconds::max());
+
+  metrics.time_to_stop_microseconds = std::max<int64_t>(0, (stop_time - events.back().time).count());
+  return metrics;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+  WheelSmoother::Options base;
+  std::vector<Sweep> sweeps;
+  std::vector<WheelEvent> events;
+  unsigned int jobs = std::max(1u, std::thread::hardware_concurrency());
+  bool show_help = false;
+  bool check = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+
+    if (arg == "-h" || arg == "--help")
+    {
+      show_help = true;
+      break;
+    }
+    else if ((arg == "-t" || arg == "--trace") && has_value)
+    {
+      if (!loadTrace(argv[++i], events))
+      {
+        std::cerr << "Failed to read trace " << argv[i] << "\n";
+        return 1;
+      }
+    }
+    else if ((arg == "-s" || arg == "--synthetic") && has_value)
+    {
+      if (!synthesize(argv[++i], events))
+      {
+        std::cerr << "Invalid synthetic gesture " << argv[i] << "\n";
+        return 1;
+      }
+    }
+    else if ((arg == "-p" || arg == "--param") && has_value)
+    {
+      Sweep sweep;
+      if (!parseSweep(argv[++i], sweep))
+      {
+        std::cerr << "Invalid sweep " << argv[i] << "\n";
+        return 1;
+      }
+      sweeps.push_back(std::move(sweep));
+    }
+    else if (arg == "--set" && has_value)
+    {
+      if (!parseSet(argv[++i], base))
+      {
+        std::cerr << "Invalid option " << argv[i] << "\n";
+        return 1;
+      }
+    }
+    else if (arg == "-c" || arg == "--check")
+    {
+      check = true;
+    }
+    else if ((arg == "-j" || arg == "--jobs") && has_value)
+    {
+      jobs = std::max(1, std::atoi(argv[++i]));
+    }
+    else
+    {
+      show_help = true;
+      break;
+    }
+  }
+
+  if (show_help || events.empty())
+  {
+    std::cout << kHelpStr;
+    return show_help ? 0 : 1;
+  }
+
+  std::sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.time < b.time; });
+
+  size_t num_configs = 1;
+  for (const auto& sweep : sweeps)
+  {
+    num_configs *= sweep.values.size();
+  }
+
+  std::vector<WheelSmoother::Options> options(num_configs, base);
+  for (size_t c = 0; c < num_configs; ++c)
+  {
+    size_t index = c;
+    for (auto sweep = sweeps.rbegin(); sweep != sweeps.rend(); ++sweep)
+    {
+      sweep->field->set(options[c], sweep->values[index % sweep->values.size()]);
+      index /= sweep->values.size();
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<BatchWheelSmoother::Metrics> results(num_configs);
+  std::vector<std::thread> workers;
+  const size_t chunk = (num_configs + jobs - 1) / jobs;
+  for (size_t begin = 0; begin < num_configs; begin += chunk)
+  {
+    const size_t end = std::min(num_configs, begin + chunk);
+    workers.emplace_back([&, begin, end]() {
+      BatchWheelSmoother batch(options, begin, end);
+      for (const auto& event : events)
+      {
+        batch.tickUntil(event.time);
+        batch.handleEvent(event.time, event.positive, event.horizontal);
+      }
+      batch.finish();
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        results[i] = batch.metrics(i - begin);
+      }
+    });
+  }
+
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cerr << "Simulated " << num_configs << " configurations over " << events.size() << " events in " << elapsed
+            << "s using " << workers.size() << " threads\n";
+
+  for (const auto& sweep : sweeps)
+  {
+    std::cout << sweep.field->name << ",";
+  }
+  std::cout << "distance,overshoot,peak_speed,time_to_stop_ms,output_events\n";
+
+  bool failed = false;
+
+  for (size_t c = 0; c < num_configs; ++c)
+  {
+    size_t index = c;
+    std::vector<double> values(sweeps.size());
+    for (size_t s = sweeps.size(); s-- > 0;)
+    {
+      values[s] = sweeps[s].values[index % sweeps[s].values.size()];
+      index /= sweeps[s].values.size();
+    }
+
+    for (double value : values)
+    {
+      std::cout << value << ",";
+    }
+
+    const auto& m = results[c];
+    std::cout << m.distance << "," << m.overshoot << "," << m.peak_speed << ","
+              << m.time_to_stop_microseconds / 1000.0 << "," << m.output_events << "\n";
+
+    if (check)
+    {
+      auto reference = referenceMetrics(options[c], events);
+      if (reference.distance != m.distance || reference.time_to_stop_microseconds != m.time_to_stop_microseconds)
+      {
+        std::cerr << "Combination " << c << ": distance " << m.distance << " and time to stop "
+                  << m.time_to_stop_microseconds << "us, WheelSmoother " << reference.distance << " and "
+                  << reference.time_to_stop_microseconds << "us\n";
+        failed = true;
+      }
+    }
+  }
+
+  return failed ? 1 : 0;
+}